@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryActorPoolSubsystem.h"
+
+#include "InventoryPooledActorInterface.h"
+#include "Item.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+namespace InventoryActorPoolSubsystem
+{
+	static TAutoConsoleVariable<int32> CVarMaxPerClass(
+		TEXT("Inventory.ActorPool.MaxPerClass"),
+		8,
+		TEXT("Most inactive item instance actors kept per class, actors released past this are destroyed."),
+		ECVF_Default);
+}
+
+UInventoryActorPoolSubsystem::UInventoryActorPoolSubsystem()
+{
+	NumSpawnedActors = 0;
+	NumReusedActors = 0;
+}
+
+AActor* UInventoryActorPoolSubsystem::AcquireActor(TSubclassOf<AActor> ActorClass, AActor* AttachTo, UItem* Item)
+{
+	if(!ActorClass)
+	{
+		return nullptr;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_InventoryActorPoolSubsystem_AcquireActor);
+
+	AActor* Actor = nullptr;
+
+	// Pooled actors can still be destroyed by a level unloading or by game code, skip any that were
+	if(FInventoryActorPool* Pool = Pools.Find(ActorClass))
+	{
+		while(!Actor && Pool->InactiveActors.Num() > 0)
+		{
+			AActor* PooledActor = Pool->InactiveActors.Pop(EAllowShrinking::No);
+			if(IsValid(PooledActor))
+			{
+				Actor = PooledActor;
+				NumReusedActors++;
+			}
+		}
+	}
+
+	if(!Actor)
+	{
+		Actor = SpawnInactiveActor(ActorClass);
+		if(!Actor)
+		{
+			return nullptr;
+		}
+
+		NumSpawnedActors++;
+	}
+
+	if(AttachTo)
+	{
+		Actor->SetOwner(AttachTo);
+		Actor->SetActorLocationAndRotation(AttachTo->GetActorLocation(), AttachTo->GetActorRotation());
+		Actor->AttachToActor(AttachTo, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	}
+
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	Actor->SetActorTickEnabled(true);
+
+	if(Actor->Implements<UInventoryPooledActorInterface>())
+	{
+		IInventoryPooledActorInterface::Execute_OnAcquiredFromPool(Actor, Item);
+	}
+
+	return Actor;
+}
+
+void UInventoryActorPoolSubsystem::ReleaseActor(AActor* Actor)
+{
+	if(!IsValid(Actor))
+	{
+		return;
+	}
+
+	if(Actor->Implements<UInventoryPooledActorInterface>())
+	{
+		IInventoryPooledActorInterface::Execute_OnReleasedToPool(Actor);
+	}
+
+	FInventoryActorPool& Pool = Pools.FindOrAdd(Actor->GetClass());
+	if(Pool.InactiveActors.Num() >= GetMaxPooledActorsPerClass())
+	{
+		Actor->Destroy();
+		return;
+	}
+
+	DeactivateActor(Actor);
+	Pool.InactiveActors.Add(Actor);
+}
+
+void UInventoryActorPoolSubsystem::PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	if(!ActorClass)
+	{
+		return;
+	}
+
+	FInventoryActorPool& Pool = Pools.FindOrAdd(ActorClass);
+	const int32 TargetCount = FMath::Min(Count, GetMaxPooledActorsPerClass());
+
+	while(Pool.InactiveActors.Num() < TargetCount)
+	{
+		AActor* Actor = SpawnInactiveActor(ActorClass);
+		if(!Actor)
+		{
+			break;
+		}
+
+		Pool.InactiveActors.Add(Actor);
+	}
+}
+
+int32 UInventoryActorPoolSubsystem::GetNumInactiveActors(TSubclassOf<AActor> ActorClass) const
+{
+	const FInventoryActorPool* Pool = Pools.Find(ActorClass);
+	return Pool ? Pool->InactiveActors.Num() : 0;
+}
+
+int32 UInventoryActorPoolSubsystem::GetMaxPooledActorsPerClass()
+{
+	return FMath::Max(0, InventoryActorPoolSubsystem::CVarMaxPerClass.GetValueOnGameThread());
+}
+
+void UInventoryActorPoolSubsystem::Deinitialize()
+{
+	// The world is going away and takes its actors with it, just let go of them
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+AActor* UInventoryActorPoolSubsystem::SpawnInactiveActor(TSubclassOf<AActor> ActorClass)
+{
+	UWorld* World = GetWorld();
+	if(!World)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+
+	AActor* Actor = World->SpawnActor<AActor>(ActorClass, FTransform::Identity, SpawnParameters);
+	if(Actor)
+	{
+		DeactivateActor(Actor);
+	}
+
+	return Actor;
+}
+
+void UInventoryActorPoolSubsystem::DeactivateActor(AActor* Actor)
+{
+	Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Actor->SetOwner(nullptr);
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+}
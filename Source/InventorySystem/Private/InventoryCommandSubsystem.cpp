@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryCommandSubsystem.h"
+
+#include "InventorySystemComponent.h"
+
+namespace InventoryCommandSubsystem
+{
+	static TAutoConsoleVariable<int32> CVarCapacity(
+		TEXT("Inventory.CommandQueue.Capacity"),
+		1024,
+		TEXT("Inventory commands a world can hold between drains, rounded up to a power of two and read when the world is created."),
+		ECVF_Default);
+}
+
+FInventoryCommandChannel::FInventoryCommandChannel(uint32 Capacity)
+	: Queue(Capacity)
+	, bClosed(false)
+	, NumRejectedCommands(0)
+{
+}
+
+bool FInventoryCommandChannel::Enqueue(FInventoryCommand&& Command)
+{
+	if(bClosed.load(std::memory_order_acquire) || !Queue.Enqueue(MoveTemp(Command)))
+	{
+		NumRejectedCommands.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+bool FInventoryCommandChannel::Dequeue(FInventoryCommand& OutCommand)
+{
+	return Queue.Dequeue(OutCommand);
+}
+
+bool FInventoryCommandChannel::IsEmpty() const
+{
+	return Queue.IsEmpty();
+}
+
+uint32 FInventoryCommandChannel::GetCapacity() const
+{
+	return Queue.GetCapacity();
+}
+
+void FInventoryCommandChannel::Close()
+{
+	bClosed.store(true, std::memory_order_release);
+}
+
+uint64 FInventoryCommandChannel::GetNumRejectedCommands() const
+{
+	return NumRejectedCommands.load(std::memory_order_relaxed);
+}
+
+void UInventoryCommandSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CommandChannel = MakeShared<FInventoryCommandChannel, ESPMode::ThreadSafe>((uint32)FMath::Max(2, InventoryCommandSubsystem::CVarCapacity.GetValueOnGameThread()));
+}
+
+void UInventoryCommandSubsystem::Deinitialize()
+{
+	// Components may still be alive to take what was queued for them
+	DrainCommands();
+
+	// Producers still holding the channel keep it alive, closing it rejects whatever they queue from now on
+	if(CommandChannel)
+	{
+		CommandChannel->Close();
+		CommandChannel.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+bool UInventoryCommandSubsystem::EnqueueCommand(FInventoryCommand&& Command)
+{
+	return CommandChannel && CommandChannel->Enqueue(MoveTemp(Command));
+}
+
+TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> UInventoryCommandSubsystem::GetCommandChannel() const
+{
+	return CommandChannel;
+}
+
+void UInventoryCommandSubsystem::DrainCommands()
+{
+	check(IsInGameThread());
+
+	if(!CommandChannel || CommandChannel->IsEmpty())
+	{
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_InventoryCommandSubsystem_DrainCommands);
+
+	/* Producers keep queueing while we drain, stop after one queue's worth so a busy producer cannot hold up the frame */
+	FInventoryCommand Command;
+	for(uint32 Count = 0; Count < CommandChannel->GetCapacity() && CommandChannel->Dequeue(Command); Count++)
+	{
+		ApplyCommand(Command);
+	}
+}
+
+uint64 UInventoryCommandSubsystem::GetNumRejectedCommands() const
+{
+	return CommandChannel ? CommandChannel->GetNumRejectedCommands() : 0;
+}
+
+void UInventoryCommandSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	DrainCommands();
+}
+
+TStatId UInventoryCommandSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryCommandSubsystem, STATGROUP_Tickables);
+}
+
+void UInventoryCommandSubsystem::ApplyCommand(FInventoryCommand& Command)
+{
+	UInventorySystemComponent* Component = Command.Component.Get();
+	if(!Component)
+	{
+		return;
+	}
+
+	switch(Command.Type)
+	{
+	case EInventoryCommandType::AddItem:
+		Component->AddItem(Command.Item, Command.StackCount);
+		break;
+	case EInventoryCommandType::RemoveItem:
+		Component->RemoveItem(Command.Item, Command.StackCount);
+		break;
+	case EInventoryCommandType::TryEquipItem:
+		Component->TryEquipItem(Command.Item, Command.EquippedSlot);
+		break;
+	case EInventoryCommandType::SetItemStateData:
+		Component->SetItemStateData(Command.Item, Command.StateData);
+		break;
+	}
+}
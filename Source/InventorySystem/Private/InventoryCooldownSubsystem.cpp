@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryCooldownSubsystem.h"
+
+#include "InventorySystemComponent.h"
+
+UInventoryCooldownSubsystem::UInventoryCooldownSubsystem()
+{
+	ElapsedTime = 0.0;
+}
+
+FInventoryTimerHandle UInventoryCooldownSubsystem::StartTimer(UInventorySystemComponent* Component, const FEquippedSlot& EquippedSlot, const UItem* Item, EInventoryCooldownTimerType Type, float Seconds)
+{
+	FInventoryCooldownTimer Timer;
+	Timer.Component = Component;
+	Timer.EquippedSlot = EquippedSlot;
+	Timer.Item = Item;
+	Timer.Type = Type;
+
+	// Timers are measured from the time the wheel has reached, not from the middle of the current tick
+	const uint64 DelayTicks = (uint64)FMath::CeilToDouble(FMath::Max(0.0, (double)Seconds) / TimerResolution);
+	return TimerWheel.Add(DelayTicks, MoveTemp(Timer));
+}
+
+void UInventoryCooldownSubsystem::CancelTimer(FInventoryTimerHandle& Handle)
+{
+	TimerWheel.Cancel(Handle);
+}
+
+bool UInventoryCooldownSubsystem::IsTimerActive(const FInventoryTimerHandle& Handle) const
+{
+	return TimerWheel.IsActive(Handle);
+}
+
+float UInventoryCooldownSubsystem::GetRemainingTime(const FInventoryTimerHandle& Handle) const
+{
+	if(!TimerWheel.IsActive(Handle))
+	{
+		return 0.f;
+	}
+
+	const double ExpireTime = (TimerWheel.GetCurrentTick() + TimerWheel.GetRemainingTicks(Handle)) * TimerResolution;
+	return (float)FMath::Max(0.0, ExpireTime - ElapsedTime);
+}
+
+int32 UInventoryCooldownSubsystem::GetActiveTimerCount() const
+{
+	return TimerWheel.Num();
+}
+
+void UInventoryCooldownSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ElapsedTime += DeltaTime;
+	if(TimerWheel.Num() == 0)
+	{
+		TimerWheel.Advance((uint64)(ElapsedTime / TimerResolution), ExpiredTimers);
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_InventoryCooldownSubsystem_ExpireTimers);
+
+	ExpiredTimers.Reset();
+	TimerWheel.Advance((uint64)(ElapsedTime / TimerResolution), ExpiredTimers);
+
+	/* Components may start new timers while handling an expiry, those go into the wheel and never into this batch */
+	for(const FInventoryCooldownTimer& Timer : ExpiredTimers)
+	{
+		if(UInventorySystemComponent* Component = Timer.Component.Get())
+		{
+			Component->HandleCooldownTimerExpired(Timer.EquippedSlot, Timer.Item, Timer.Type);
+		}
+	}
+
+	ExpiredTimers.Reset();
+}
+
+TStatId UInventoryCooldownSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInventoryCooldownSubsystem, STATGROUP_Tickables);
+}
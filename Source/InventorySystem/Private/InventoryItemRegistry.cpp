@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryItemRegistry.h"
+
+#include "Item.h"
+#include "Engine/Engine.h"
+
+UInventoryItemRegistry* UInventoryItemRegistry::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UInventoryItemRegistry>() : nullptr;
+}
+
+int32 UInventoryItemRegistry::PinItem(UItem* Item)
+{
+	if(!Item)
+	{
+		return INDEX_NONE;
+	}
+
+	if(const int32* ExistingIndex = ItemIndices.Find(Item))
+	{
+		RefCounts[*ExistingIndex]++;
+		return *ExistingIndex;
+	}
+
+	int32 Index;
+	if(FreeIndices.Num() > 0)
+	{
+		Index = FreeIndices.Pop(EAllowShrinking::No);
+		Items[Index] = Item;
+		RefCounts[Index] = 1;
+	}
+	else
+	{
+		Index = Items.Add(Item);
+		RefCounts.Add(1);
+	}
+
+	ItemIndices.Add(Item, Index);
+	return Index;
+}
+
+void UInventoryItemRegistry::UnpinItem(UItem* Item)
+{
+	const int32* Index = Item ? ItemIndices.Find(Item) : nullptr;
+	if(!Index)
+	{
+		return;
+	}
+
+	const int32 ReleasedIndex = *Index;
+	if(--RefCounts[ReleasedIndex] > 0)
+	{
+		return;
+	}
+
+	Items[ReleasedIndex] = nullptr;
+	ItemIndices.Remove(Item);
+	FreeIndices.Add(ReleasedIndex);
+}
+
+UItem* UInventoryItemRegistry::GetItem(int32 Index) const
+{
+	return Items.IsValidIndex(Index) ? Items[Index] : nullptr;
+}
+
+int32 UInventoryItemRegistry::IndexOf(const UItem* Item) const
+{
+	const int32* Index = ItemIndices.Find(Item);
+	return Index ? *Index : INDEX_NONE;
+}
+
+int32 UInventoryItemRegistry::GetNumPinnedItems() const
+{
+	return ItemIndices.Num();
+}
+
+void UInventoryItemRegistry::Deinitialize()
+{
+	Items.Empty();
+	RefCounts.Empty();
+	ItemIndices.Empty();
+	FreeIndices.Empty();
+
+	Super::Deinitialize();
+}
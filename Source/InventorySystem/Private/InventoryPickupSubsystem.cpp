@@ -0,0 +1,514 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryPickupSubsystem.h"
+
+#include "InventoryItemRegistry.h"
+#include "InventorySystemComponent.h"
+#include "Item.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+namespace InventoryPickupSubsystem
+{
+	static TAutoConsoleVariable<float> CVarCellSize(
+		TEXT("Inventory.Pickups.CellSize"),
+		1000.f,
+		TEXT("Edge length of the grid cells world drops are bucketed into, read when a world is created. Best set close to the usual pickup query radius."),
+		ECVF_Default);
+
+	static TAutoConsoleVariable<bool> CVarRenderProxies(
+		TEXT("Inventory.Pickups.RenderProxies"),
+		true,
+		TEXT("Draw world drops of items with a PickupMesh through instanced static meshes, read when a world is created."),
+		ECVF_Default);
+}
+
+UInventoryPickupSubsystem::UInventoryPickupSubsystem()
+{
+	FreeList = INDEX_NONE;
+	NumDrops = 0;
+	NumOptionalObjectReferences = 0;
+	bItemsPinned = false;
+	CellSize = 1000.f;
+	bRenderProxies = false;
+	ProxyActor = nullptr;
+}
+
+void UInventoryPickupSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(1.f, InventoryPickupSubsystem::CVarCellSize.GetValueOnGameThread());
+	bItemsPinned = UInventoryItemRegistry::Get() != nullptr;
+
+	const UWorld* World = GetWorld();
+	bRenderProxies = InventoryPickupSubsystem::CVarRenderProxies.GetValueOnGameThread() && World && World->IsGameWorld() && !IsRunningDedicatedServer();
+}
+
+void UInventoryPickupSubsystem::Deinitialize()
+{
+	if(UInventoryItemRegistry* ItemRegistry = bItemsPinned ? UInventoryItemRegistry::Get() : nullptr)
+	{
+		for(const FWorldDrop& Drop : Drops)
+		{
+			if(Drop.bActive)
+			{
+				ItemRegistry->UnpinItem(Drop.Item);
+			}
+		}
+	}
+
+	// Proxy components go away with the world
+	Drops.Empty();
+	CellHeads.Empty();
+	Proxies.Empty();
+	ProxyActor = nullptr;
+	FreeList = INDEX_NONE;
+	NumDrops = 0;
+	NumOptionalObjectReferences = 0;
+	bItemsPinned = false;
+
+	Super::Deinitialize();
+}
+
+void UInventoryPickupSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UInventoryPickupSubsystem* This = CastChecked<UInventoryPickupSubsystem>(InThis);
+
+	/* Pinned items are kept alive by the item registry, only walk our drops if something else needs reporting. Once the
+	 * registry is gone at engine shutdown it no longer holds them, so we report everything again */
+	const bool bItemsArePinned = This->bItemsPinned && UInventoryItemRegistry::Get();
+	if(!bItemsArePinned || This->NumOptionalObjectReferences > 0)
+	{
+		for(FWorldDrop& Drop : This->Drops)
+		{
+			if(!Drop.bActive)
+			{
+				continue;
+			}
+
+			if(!bItemsArePinned)
+			{
+				Collector.AddReferencedObject(Drop.Item, This);
+			}
+
+			Collector.AddReferencedObject(Drop.StateData.OptionalObject, This);
+		}
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+FInventoryDropHandle UInventoryPickupSubsystem::DropItem(UItem* Item, int32 StackCount, FItemStateData StateData, FVector Location)
+{
+	if(!Item || StackCount <= 0)
+	{
+		return FInventoryDropHandle();
+	}
+
+	int32 DropIndex = FreeList;
+	if(DropIndex != INDEX_NONE)
+	{
+		FreeList = Drops[DropIndex].NextInCell;
+	}
+	else
+	{
+		DropIndex = Drops.AddDefaulted();
+	}
+
+	FWorldDrop& Drop = Drops[DropIndex];
+	Drop.Item = Item;
+	Drop.StackCount = StackCount;
+	Drop.StateData = StateData;
+	Drop.StateData.LocationData = Location;
+	Drop.ProxyInstance = INDEX_NONE;
+	Drop.bActive = true;
+
+	if(UInventoryItemRegistry* ItemRegistry = bItemsPinned ? UInventoryItemRegistry::Get() : nullptr)
+	{
+		ItemRegistry->PinItem(Item);
+	}
+
+	if(Drop.StateData.OptionalObject)
+	{
+		NumOptionalObjectReferences++;
+	}
+
+	NumDrops++;
+	LinkToCell(DropIndex);
+	AddProxyInstance(DropIndex);
+
+	FInventoryDropHandle Handle;
+	Handle.Index = DropIndex;
+	Handle.Serial = Drop.Serial;
+	return Handle;
+}
+
+bool UInventoryPickupSubsystem::RemoveDrop(FInventoryDropHandle Handle)
+{
+	if(!FindDrop(Handle))
+	{
+		return false;
+	}
+
+	ReleaseDrop(Handle.Index);
+	return true;
+}
+
+bool UInventoryPickupSubsystem::MoveDrop(FInventoryDropHandle Handle, FVector NewLocation)
+{
+	FWorldDrop* Drop = FindDrop(Handle);
+	if(!Drop)
+	{
+		return false;
+	}
+
+	Drop->StateData.LocationData = NewLocation;
+
+	if(GetCell(NewLocation) != Drop->Cell)
+	{
+		UnlinkFromCell(Handle.Index);
+		LinkToCell(Handle.Index);
+	}
+
+	UpdateProxyInstance(Handle.Index);
+	return true;
+}
+
+bool UInventoryPickupSubsystem::IsDropValid(FInventoryDropHandle Handle) const
+{
+	return FindDrop(Handle) != nullptr;
+}
+
+bool UInventoryPickupSubsystem::GetDrop(FInventoryDropHandle Handle, UItem*& OutItem, int32& OutStackCount, FItemStateData& OutStateData) const
+{
+	const FWorldDrop* Drop = FindDrop(Handle);
+	if(!Drop)
+	{
+		OutItem = nullptr;
+		OutStackCount = 0;
+		OutStateData = FItemStateData();
+		return false;
+	}
+
+	OutItem = Drop->Item;
+	OutStackCount = Drop->StackCount;
+	OutStateData = Drop->StateData;
+	return true;
+}
+
+int32 UInventoryPickupSubsystem::PickupDrop(FInventoryDropHandle Handle, UInventorySystemComponent* InventorySystemComponent)
+{
+	const FWorldDrop* Drop = FindDrop(Handle);
+	if(!Drop || !InventorySystemComponent)
+	{
+		return 0;
+	}
+
+	// Copy what we need, listeners of the inventory may drop items and grow our storage while we add
+	UItem* Item = Drop->Item;
+	const int32 StackCount = Drop->StackCount;
+	const FItemStateData StateData = Drop->StateData;
+
+	const int32 OldStackCount = InventorySystemComponent->GetItemStackCount(Item);
+	if(!InventorySystemComponent->AddItem(Item, StackCount))
+	{
+		return 0;
+	}
+
+	const int32 PickedUp = FMath::Clamp(InventorySystemComponent->GetItemStackCount(Item) - OldStackCount, 0, StackCount);
+
+	// An item new to the inventory takes its state with it, an existing stack keeps its own
+	if(OldStackCount <= 0)
+	{
+		InventorySystemComponent->SetItemStateData(Item, StateData);
+	}
+
+	if(FWorldDrop* RemainingDrop = FindDrop(Handle))
+	{
+		if(PickedUp >= RemainingDrop->StackCount)
+		{
+			ReleaseDrop(Handle.Index);
+		}
+		else
+		{
+			RemainingDrop->StackCount -= PickedUp;
+		}
+	}
+
+	return PickedUp;
+}
+
+void UInventoryPickupSubsystem::QueryDropsInRadius(FVector Center, float Radius, TArray<FInventoryDropHandle>& OutDrops) const
+{
+	GatherDropsInRadius(Center, Radius, OutDrops);
+}
+
+void UInventoryPickupSubsystem::QueryDropsInRadii(TConstArrayView<FInventoryDropQuery> Queries, TArray<FInventoryDropHandle>& OutDrops, TArray<int32>& OutQueryStarts) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_InventoryPickupSubsystem_QueryDropsInRadii);
+
+	OutQueryStarts.Reset(Queries.Num());
+
+	for(const FInventoryDropQuery& Query : Queries)
+	{
+		OutQueryStarts.Add(OutDrops.Num());
+		GatherDropsInRadius(Query.Center, Query.Radius, OutDrops);
+	}
+}
+
+int32 UInventoryPickupSubsystem::GetNumDrops() const
+{
+	return NumDrops;
+}
+
+SIZE_T UInventoryPickupSubsystem::GetAllocatedSize() const
+{
+	SIZE_T Size = Drops.GetAllocatedSize() + CellHeads.GetAllocatedSize() + Proxies.GetAllocatedSize();
+	for(const TPair<const UStaticMesh*, FDropProxy>& Pair : Proxies)
+	{
+		Size += Pair.Value.InstanceDrops.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+UInventoryPickupSubsystem::FWorldDrop* UInventoryPickupSubsystem::FindDrop(const FInventoryDropHandle& Handle)
+{
+	return Drops.IsValidIndex(Handle.Index) && Drops[Handle.Index].bActive && Drops[Handle.Index].Serial == Handle.Serial ? &Drops[Handle.Index] : nullptr;
+}
+
+const UInventoryPickupSubsystem::FWorldDrop* UInventoryPickupSubsystem::FindDrop(const FInventoryDropHandle& Handle) const
+{
+	return const_cast<UInventoryPickupSubsystem*>(this)->FindDrop(Handle);
+}
+
+FIntPoint UInventoryPickupSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UInventoryPickupSubsystem::LinkToCell(int32 DropIndex)
+{
+	FWorldDrop& Drop = Drops[DropIndex];
+	Drop.Cell = GetCell(Drop.StateData.LocationData);
+
+	int32& Head = CellHeads.FindOrAdd(Drop.Cell, INDEX_NONE);
+	Drop.PrevInCell = INDEX_NONE;
+	Drop.NextInCell = Head;
+	if(Head != INDEX_NONE)
+	{
+		Drops[Head].PrevInCell = DropIndex;
+	}
+
+	Head = DropIndex;
+}
+
+void UInventoryPickupSubsystem::UnlinkFromCell(int32 DropIndex)
+{
+	FWorldDrop& Drop = Drops[DropIndex];
+
+	if(Drop.PrevInCell != INDEX_NONE)
+	{
+		Drops[Drop.PrevInCell].NextInCell = Drop.NextInCell;
+	}
+	else if(Drop.NextInCell != INDEX_NONE)
+	{
+		CellHeads.FindChecked(Drop.Cell) = Drop.NextInCell;
+	}
+	else
+	{
+		// Last drop in the cell, empty cells are dropped so the grid only grows with the area drops cover
+		CellHeads.Remove(Drop.Cell);
+	}
+
+	if(Drop.NextInCell != INDEX_NONE)
+	{
+		Drops[Drop.NextInCell].PrevInCell = Drop.PrevInCell;
+	}
+
+	Drop.PrevInCell = INDEX_NONE;
+	Drop.NextInCell = INDEX_NONE;
+}
+
+void UInventoryPickupSubsystem::GatherDropsInRadius(const FVector& Center, float Radius, TArray<FInventoryDropHandle>& OutDrops) const
+{
+	if(Radius < 0.f || NumDrops == 0)
+	{
+		return;
+	}
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius));
+	const float RadiusSquared = Radius * Radius;
+
+	/* A query much larger than the area drops cover would visit mostly empty cells, walk the occupied cells instead */
+	const int64 NumQueryCells = (int64)(MaxCell.X - MinCell.X + 1) * (int64)(MaxCell.Y - MinCell.Y + 1);
+	if(NumQueryCells > CellHeads.Num())
+	{
+		for(const TPair<FIntPoint, int32>& Pair : CellHeads)
+		{
+			if(Pair.Key.X >= MinCell.X && Pair.Key.X <= MaxCell.X && Pair.Key.Y >= MinCell.Y && Pair.Key.Y <= MaxCell.Y)
+			{
+				GatherDropsInCell(Pair.Value, Center, RadiusSquared, OutDrops);
+			}
+		}
+
+		return;
+	}
+
+	for(int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+	{
+		for(int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			if(const int32* Head = CellHeads.Find(FIntPoint(X, Y)))
+			{
+				GatherDropsInCell(*Head, Center, RadiusSquared, OutDrops);
+			}
+		}
+	}
+}
+
+void UInventoryPickupSubsystem::GatherDropsInCell(int32 DropIndex, const FVector& Center, float RadiusSquared, TArray<FInventoryDropHandle>& OutDrops) const
+{
+	while(DropIndex != INDEX_NONE)
+	{
+		const FWorldDrop& Drop = Drops[DropIndex];
+		if(FVector::DistSquared(Drop.StateData.LocationData, Center) <= RadiusSquared)
+		{
+			FInventoryDropHandle& Handle = OutDrops.AddDefaulted_GetRef();
+			Handle.Index = DropIndex;
+			Handle.Serial = Drop.Serial;
+		}
+
+		DropIndex = Drop.NextInCell;
+	}
+}
+
+void UInventoryPickupSubsystem::AddProxyInstance(int32 DropIndex)
+{
+	FWorldDrop& Drop = Drops[DropIndex];
+	UStaticMesh* PickupMesh = Drop.Item->PickupMesh;
+	if(!bRenderProxies || !PickupMesh)
+	{
+		return;
+	}
+
+	FDropProxy& Proxy = Proxies.FindOrAdd(PickupMesh);
+	UInstancedStaticMeshComponent* Component = Proxy.Component.Get();
+
+	if(!Component)
+	{
+		UWorld* World = GetWorld();
+		if(!ProxyActor)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			ProxyActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+			if(!ProxyActor)
+			{
+				return;
+			}
+
+			USceneComponent* Root = NewObject<USceneComponent>(ProxyActor, TEXT("Root"));
+			ProxyActor->SetRootComponent(Root);
+			Root->RegisterComponent();
+		}
+
+		// Instances are placed in world space on an actor sitting at the origin, and removed by swapping in the last one
+		Component = NewObject<UInstancedStaticMeshComponent>(ProxyActor);
+		Component->bSupportRemoveAtSwap = true;
+		Component->SetStaticMesh(PickupMesh);
+		Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Component->SetupAttachment(ProxyActor->GetRootComponent());
+		Component->RegisterComponent();
+		ProxyActor->AddInstanceComponent(Component);
+
+		Proxy.Component = Component;
+		Proxy.InstanceDrops.Reset();
+	}
+
+	Drop.ProxyInstance = Component->AddInstance(FTransform(Drop.StateData.LocationData), true);
+	if(Drop.ProxyInstance != INDEX_NONE)
+	{
+		Proxy.InstanceDrops.Add(DropIndex);
+	}
+}
+
+void UInventoryPickupSubsystem::RemoveProxyInstance(int32 DropIndex)
+{
+	FWorldDrop& Drop = Drops[DropIndex];
+	if(Drop.ProxyInstance == INDEX_NONE)
+	{
+		return;
+	}
+
+	if(FDropProxy* Proxy = Proxies.Find(Drop.Item->PickupMesh))
+	{
+		if(UInstancedStaticMeshComponent* Component = Proxy->Component.Get())
+		{
+			Component->RemoveInstance(Drop.ProxyInstance);
+		}
+
+		/* Mirror the component's swap removal, the drop drawn by the last instance now owns the removed index */
+		const int32 LastInstance = Proxy->InstanceDrops.Num() - 1;
+		if(Drop.ProxyInstance != LastInstance && Proxy->InstanceDrops.IsValidIndex(LastInstance))
+		{
+			const int32 MovedDropIndex = Proxy->InstanceDrops[LastInstance];
+			Proxy->InstanceDrops[Drop.ProxyInstance] = MovedDropIndex;
+			Drops[MovedDropIndex].ProxyInstance = Drop.ProxyInstance;
+		}
+
+		if(LastInstance >= 0)
+		{
+			Proxy->InstanceDrops.Pop(EAllowShrinking::No);
+		}
+	}
+
+	Drop.ProxyInstance = INDEX_NONE;
+}
+
+void UInventoryPickupSubsystem::UpdateProxyInstance(int32 DropIndex)
+{
+	const FWorldDrop& Drop = Drops[DropIndex];
+	if(Drop.ProxyInstance == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FDropProxy* Proxy = Proxies.Find(Drop.Item->PickupMesh);
+	if(UInstancedStaticMeshComponent* Component = Proxy ? Proxy->Component.Get() : nullptr)
+	{
+		Component->UpdateInstanceTransform(Drop.ProxyInstance, FTransform(Drop.StateData.LocationData), true, true);
+	}
+}
+
+void UInventoryPickupSubsystem::ReleaseDrop(int32 DropIndex)
+{
+	RemoveProxyInstance(DropIndex);
+	UnlinkFromCell(DropIndex);
+
+	FWorldDrop& Drop = Drops[DropIndex];
+
+	if(UInventoryItemRegistry* ItemRegistry = bItemsPinned ? UInventoryItemRegistry::Get() : nullptr)
+	{
+		ItemRegistry->UnpinItem(Drop.Item);
+	}
+
+	if(Drop.StateData.OptionalObject)
+	{
+		NumOptionalObjectReferences--;
+	}
+
+	Drop.Item = nullptr;
+	Drop.StackCount = 0;
+	Drop.StateData = FItemStateData();
+	Drop.bActive = false;
+	Drop.Serial++;
+	Drop.NextInCell = FreeList;
+	FreeList = DropIndex;
+	NumDrops--;
+}
@@ -0,0 +1,427 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryReplayCommandlet.h"
+
+#include "InventorySystemComponent.h"
+#include "InventoryTrace.h"
+#include "Item.h"
+#include "CoreGlobals.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogInventoryReplay, Log, All);
+
+namespace InventoryReplay
+{
+	struct FTrace
+	{
+		TMap<uint32, FString> Definitions;
+		TArray<FInventoryTraceRecord> Records;
+	};
+
+	/* A record with every id resolved, so the timed replay loop only calls into the component */
+	struct FPreparedOp
+	{
+		uint64 Frame;
+		EInventoryTraceOp Op;
+		UInventorySystemComponent* Component;
+		UItem* Item;
+		int32 IntArg;
+		FEquippedSlot Slot;
+		FItemStateData StateData;
+	};
+
+	/* Latency histogram, bucket N counts operations that took [2^N, 2^(N+1)) nanoseconds */
+	struct FOpStats
+	{
+		static constexpr int32 NumBuckets = 40;
+
+		uint64 Count = 0;
+		double TotalSeconds = 0.0;
+		uint64 Buckets[NumBuckets] = {};
+
+		void Add(double Seconds)
+		{
+			const uint64 Nanoseconds = FMath::Max<uint64>(1, (uint64)(Seconds * 1e9));
+			Buckets[FMath::Min<int32>(NumBuckets - 1, (int32)FMath::FloorLog2_64(Nanoseconds))]++;
+			TotalSeconds += Seconds;
+			Count++;
+		}
+
+		/* Upper bound of the bucket holding the given percentile, in nanoseconds */
+		uint64 GetPercentile(double Percentile) const
+		{
+			const uint64 Target = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(Count * Percentile));
+			uint64 Cumulative = 0;
+			for(int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+			{
+				Cumulative += Buckets[Bucket];
+				if(Cumulative >= Target)
+				{
+					return 1ull << (Bucket + 1);
+				}
+			}
+
+			return 1ull << NumBuckets;
+		}
+	};
+
+	static bool LoadTrace(const FString& Filename, FTrace& OutTrace)
+	{
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+		if(!Reader)
+		{
+			UE_LOG(LogInventoryReplay, Error, TEXT("Could not open trace %s"), *Filename);
+			return false;
+		}
+
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		*Reader << Magic << Version;
+
+		if(Magic != InventoryTraceFormat::Magic || Version != InventoryTraceFormat::Version)
+		{
+			UE_LOG(LogInventoryReplay, Error, TEXT("%s is not an inventory trace or was written by an unsupported version (%u)"), *Filename, Version);
+			return false;
+		}
+
+		while(!Reader->AtEnd() && !Reader->IsError())
+		{
+			uint8 ChunkType = 0;
+			uint32 Count = 0;
+			*Reader << ChunkType << Count;
+
+			if(ChunkType == InventoryTraceFormat::DefinitionsChunk)
+			{
+				for(uint32 i = 0; i < Count; i++)
+				{
+					uint32 Id = 0;
+					uint8 Kind = 0;
+					FString Value;
+					Reader->SerializeIntPacked(Id);
+					*Reader << Kind << Value;
+					OutTrace.Definitions.Add(Id, MoveTemp(Value));
+				}
+			}
+			else if(ChunkType == InventoryTraceFormat::RecordsChunk)
+			{
+				OutTrace.Records.Reserve(OutTrace.Records.Num() + Count);
+				for(uint32 i = 0; i < Count; i++)
+				{
+					*Reader << OutTrace.Records.AddDefaulted_GetRef();
+				}
+			}
+			else
+			{
+				UE_LOG(LogInventoryReplay, Error, TEXT("Unknown chunk type %u in %s"), ChunkType, *Filename);
+				return false;
+			}
+		}
+
+		return !Reader->IsError();
+	}
+
+	// Idle stretches longer than this many frames are run as one tick carrying the rest of their time
+	constexpr uint64 MaxTickedFramesPerGap = 600;
+
+	/* Runs one frame of the replay world, timers, deferred events, queued commands and viewer broadcasts happen here as
+	 * they did between the recorded calls */
+	static void TickFrame(UWorld* World, float DeltaSeconds)
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+		GFrameCounter++;
+	}
+
+	/* Order independent checksum of everything a component stores */
+	static uint32 GetStateChecksum(UInventorySystemComponent* Component)
+	{
+		TArray<UItem*> Items;
+		Component->GetInventoryItems(FPrimaryAssetType(), Items);
+		Items.Sort([](const UItem& A, const UItem& B) { return A.GetPathName() < B.GetPathName(); });
+
+		uint32 Checksum = 0;
+		for(UItem* Item : Items)
+		{
+			const FItemStateData StateData = Component->GetItemStateData(Item);
+			Checksum = HashCombine(Checksum, FCrc::StrCrc32(*Item->GetPathName()));
+			Checksum = HashCombine(Checksum, (uint32)Component->GetItemStackCount(Item));
+			Checksum = HashCombine(Checksum, GetTypeHash(StateData.Magnitude));
+			Checksum = HashCombine(Checksum, GetTypeHash(StateData.LocationData));
+			Checksum = HashCombine(Checksum, StateData.OptionalObject ? FCrc::StrCrc32(*StateData.OptionalObject->GetPathName()) : 0);
+		}
+
+		TArray<FEquippedSlot> Slots;
+		Component->GetEquipmentSlots(Slots);
+		Slots.Sort([](const FEquippedSlot& A, const FEquippedSlot& B)
+		{
+			const int32 TypeOrder = A.SlotType.GetName().Compare(B.SlotType.GetName());
+			return TypeOrder != 0 ? TypeOrder < 0 : A.SlotNumber < B.SlotNumber;
+		});
+
+		for(const FEquippedSlot& Slot : Slots)
+		{
+			const UItem* Item = Component->GetItemAtEquipmentSlot(Slot);
+			Checksum = HashCombine(Checksum, GetTypeHash(Slot));
+			Checksum = HashCombine(Checksum, Item ? FCrc::StrCrc32(*Item->GetPathName()) : 0);
+		}
+
+		return Checksum;
+	}
+}
+
+UInventoryReplayCommandlet::UInventoryReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UInventoryReplayCommandlet::Main(const FString& Params)
+{
+	using namespace InventoryReplay;
+
+	FString Filename;
+	if(!FParse::Value(*Params, TEXT("Trace="), Filename))
+	{
+		UE_LOG(LogInventoryReplay, Error, TEXT("Usage: -run=InventoryReplay -Trace=<File> [-FrameTime=<Seconds>]"));
+		return 1;
+	}
+
+	// Traces only record frame numbers, every recorded frame is replayed as taking this long
+	float FrameSeconds = 1.f / 60.f;
+	FParse::Value(*Params, TEXT("FrameTime="), FrameSeconds);
+
+	FTrace Trace;
+	if(!LoadTrace(Filename, Trace))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogInventoryReplay, Display, TEXT("Loaded %d records and %d definitions from %s"), Trace.Records.Num(), Trace.Definitions.Num(), *Filename);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("InventoryReplayWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	TMap<uint32, UInventorySystemComponent*> Components;
+	TMap<uint32, UObject*> Objects;
+	TMap<uint32, FName> Names;
+	int32 UnresolvedRecords = 0;
+
+	auto ResolveObject = [this, &Trace, &Objects](uint32 Id) -> UObject*
+	{
+		if(Id == 0)
+		{
+			return nullptr;
+		}
+
+		if(UObject** Existing = Objects.Find(Id))
+		{
+			return *Existing;
+		}
+
+		UObject* Object = nullptr;
+		if(const FString* Path = Trace.Definitions.Find(Id))
+		{
+			Object = StaticLoadObject(UObject::StaticClass(), nullptr, **Path, nullptr, LOAD_NoWarn | LOAD_Quiet);
+		}
+
+		if(Object)
+		{
+			LoadedObjects.Add(Object);
+		}
+
+		Objects.Add(Id, Object);
+		return Object;
+	};
+
+	auto ResolveName = [&Trace, &Names](uint32 Id) -> FName
+	{
+		if(Id == 0)
+		{
+			return NAME_None;
+		}
+
+		if(const FName* Existing = Names.Find(Id))
+		{
+			return *Existing;
+		}
+
+		const FString* Value = Trace.Definitions.Find(Id);
+		return Names.Add(Id, Value ? FName(**Value) : NAME_None);
+	};
+
+	auto ResolveComponent = [World, &Components](uint32 Id) -> UInventorySystemComponent*
+	{
+		if(UInventorySystemComponent** Existing = Components.Find(Id))
+		{
+			return *Existing;
+		}
+
+		AActor* Actor = World->SpawnActor<AActor>();
+		UInventorySystemComponent* Component = NewObject<UInventorySystemComponent>(Actor);
+		Component->RegisterComponent();
+		Component->InitActorInfo(Actor, Actor);
+		return Components.Add(Id, Component);
+	};
+
+	/* Resolve everything up front so the timed loop measures the component and nothing else */
+	TArray<FPreparedOp> Ops;
+	Ops.Reserve(Trace.Records.Num());
+	for(const FInventoryTraceRecord& Record : Trace.Records)
+	{
+		FPreparedOp& Op = Ops.AddDefaulted_GetRef();
+		Op.Frame = Record.Frame;
+		Op.Op = Record.Op;
+		Op.Component = ResolveComponent(Record.ComponentId);
+		Op.Item = Cast<UItem>(ResolveObject(Record.ItemId));
+		Op.IntArg = Record.IntArg;
+		Op.Slot = FEquippedSlot(FPrimaryAssetType(ResolveName(Record.NameId)), Record.SlotNumber);
+		Op.StateData.Magnitude = Record.Magnitude;
+		Op.StateData.LocationData = FVector(Record.Location);
+		Op.StateData.OptionalObject = ResolveObject(Record.OptionalObjectId);
+
+		if(Record.ItemId != 0 && !Op.Item)
+		{
+			UnresolvedRecords++;
+		}
+	}
+
+	if(UnresolvedRecords > 0)
+	{
+		UE_LOG(LogInventoryReplay, Warning, TEXT("%d records reference items that could not be loaded, they will replay with no item"), UnresolvedRecords);
+	}
+
+	FOpStats Stats[(int32)EInventoryTraceOp::Count];
+	TArray<UItem*> ScratchItems;
+	FEquippedSlot ScratchSlot;
+
+	uint64 CurrentFrame = Ops.IsEmpty() ? 0 : Ops[0].Frame;
+	uint64 NumTickedFrames = 0;
+	double TickSeconds = 0.0;
+
+	const double ReplayStartTime = FPlatformTime::Seconds();
+	for(FPreparedOp& Op : Ops)
+	{
+		// Run the frames that passed since the previous record before this one, outside of any operation's timing
+		if(Op.Frame != CurrentFrame)
+		{
+			const double TickStartTime = FPlatformTime::Seconds();
+			const uint64 NumFrames = Op.Frame > CurrentFrame ? Op.Frame - CurrentFrame : 1;
+			const uint64 NumTicks = FMath::Min(NumFrames, MaxTickedFramesPerGap);
+
+			for(uint64 Tick = 1; Tick <= NumTicks; Tick++)
+			{
+				TickFrame(World, Tick < NumTicks ? FrameSeconds : FrameSeconds * (NumFrames - NumTicks + 1));
+			}
+
+			TickSeconds += FPlatformTime::Seconds() - TickStartTime;
+			NumTickedFrames += NumTicks;
+			CurrentFrame = Op.Frame;
+		}
+
+		UInventorySystemComponent* Component = Op.Component;
+		ScratchItems.Reset();
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		switch(Op.Op)
+		{
+		case EInventoryTraceOp::AddItem: Component->AddItem(Op.Item, Op.IntArg, false); break;
+		case EInventoryTraceOp::AddItemAndEquip: Component->AddItem(Op.Item, Op.IntArg, true); break;
+		case EInventoryTraceOp::RemoveItem: Component->RemoveItem(Op.Item, Op.IntArg); break;
+		case EInventoryTraceOp::SetItemStateData: Component->SetItemStateData(Op.Item, Op.StateData); break;
+		case EInventoryTraceOp::GetItemStateData: Component->GetItemStateData(Op.Item); break;
+		case EInventoryTraceOp::GetInventoryItems: Component->GetInventoryItems(Op.Slot.SlotType, ScratchItems); break;
+		case EInventoryTraceOp::GetItemStackCount: Component->GetItemStackCount(Op.Item); break;
+		case EInventoryTraceOp::HasItem: Component->HasItem(Op.Item); break;
+		case EInventoryTraceOp::TryEquipItem: Component->TryEquipItem(Op.Item, Op.Slot); break;
+		case EInventoryTraceOp::UseItemAtEquipmentSlot: Component->UseItemAtEquipmentSlot(Op.Slot); break;
+		case EInventoryTraceOp::GetTotalEquipmentSlotsOfType: Component->GetTotalEquipmentSlotsOfType(Op.Slot.SlotType); break;
+		case EInventoryTraceOp::IsItemEquipped: Component->IsItemEquipped(Op.Item, ScratchSlot); break;
+		case EInventoryTraceOp::GetItemAtEquipmentSlot: Component->GetItemAtEquipmentSlot(Op.Slot); break;
+		case EInventoryTraceOp::GetFirstAvailableEquipmentSlot: Component->GetFirstAvailableEquipmentSlot(Op.Slot.SlotType, ScratchSlot); break;
+		case EInventoryTraceOp::AddItemToEquipmentSlot: Component->AddItemToEquipmentSlot(Op.Slot, Op.Item); break;
+		case EInventoryTraceOp::RemoveItemFromEquipmentSlot: Component->RemoveItemFromEquipmentSlot(Op.Slot); break;
+		case EInventoryTraceOp::AddEquipmentSlot: Component->AddEquipmentSlot(Op.Slot); break;
+		case EInventoryTraceOp::SaveEquipmentLoadout: Component->SaveEquipmentLoadout(Op.Slot.SlotType.GetName()); break;
+		case EInventoryTraceOp::ApplyEquipmentLoadout: Component->ApplyEquipmentLoadout(Op.Slot.SlotType.GetName()); break;
+		case EInventoryTraceOp::RemoveEquipmentLoadout: Component->RemoveEquipmentLoadout(Op.Slot.SlotType.GetName()); break;
+		default: continue;
+		}
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+
+		Stats[(int32)Op.Op].Add(FPlatformTime::ToSeconds64(EndCycles - StartCycles));
+	}
+
+	// The frame of the last record ends like any other, its deferred events are flushed before we checksum
+	if(!Ops.IsEmpty())
+	{
+		const double TickStartTime = FPlatformTime::Seconds();
+		TickFrame(World, FrameSeconds);
+		TickSeconds += FPlatformTime::Seconds() - TickStartTime;
+		NumTickedFrames++;
+	}
+
+	const double ReplaySeconds = FPlatformTime::Seconds() - ReplayStartTime - TickSeconds;
+
+	double OpSeconds = 0.0;
+	for(const FOpStats& OpStats : Stats)
+	{
+		OpSeconds += OpStats.TotalSeconds;
+	}
+
+	UE_LOG(LogInventoryReplay, Display, TEXT("Replayed %d operations on %d components in %.3f ms (%.3f ms inside the component), %.0f ops/s"),
+		Ops.Num(), Components.Num(), ReplaySeconds * 1000.0, OpSeconds * 1000.0, OpSeconds > 0.0 ? Ops.Num() / OpSeconds : 0.0);
+	UE_LOG(LogInventoryReplay, Display, TEXT("Ticked %llu frames of %.1f ms in between, %.3f ms not counted above"), NumTickedFrames, FrameSeconds * 1000.0, TickSeconds * 1000.0);
+
+	UE_LOG(LogInventoryReplay, Display, TEXT("%-32s %10s %10s %10s %10s %10s"), TEXT("Operation"), TEXT("Count"), TEXT("Mean ns"), TEXT("p50 ns"), TEXT("p99 ns"), TEXT("p99.9 ns"));
+	for(int32 OpIndex = 0; OpIndex < (int32)EInventoryTraceOp::Count; OpIndex++)
+	{
+		const FOpStats& OpStats = Stats[OpIndex];
+		if(OpStats.Count == 0)
+		{
+			continue;
+		}
+
+		UE_LOG(LogInventoryReplay, Display, TEXT("%-32s %10llu %10.0f %10llu %10llu %10llu"), LexToString((EInventoryTraceOp)OpIndex), OpStats.Count,
+			OpStats.TotalSeconds * 1e9 / OpStats.Count, OpStats.GetPercentile(0.5), OpStats.GetPercentile(0.99), OpStats.GetPercentile(0.999));
+
+		FString Histogram;
+		for(int32 Bucket = 0; Bucket < FOpStats::NumBuckets; Bucket++)
+		{
+			if(OpStats.Buckets[Bucket] > 0)
+			{
+				Histogram += FString::Printf(TEXT(" [%llu ns: %llu]"), 1ull << Bucket, OpStats.Buckets[Bucket]);
+			}
+		}
+		UE_LOG(LogInventoryReplay, Display, TEXT("    %s"), *Histogram);
+	}
+
+	TArray<uint32> ComponentIds;
+	Components.GetKeys(ComponentIds);
+	ComponentIds.Sort();
+
+	uint32 WorldChecksum = 0;
+	for(uint32 ComponentId : ComponentIds)
+	{
+		const uint32 ComponentChecksum = GetStateChecksum(Components[ComponentId]);
+		const FString* ComponentPath = Trace.Definitions.Find(ComponentId);
+		UE_LOG(LogInventoryReplay, Verbose, TEXT("Checksum %08x for %s"), ComponentChecksum, ComponentPath ? **ComponentPath : TEXT("Unknown"));
+		WorldChecksum = HashCombine(WorldChecksum, ComponentChecksum);
+	}
+
+	UE_LOG(LogInventoryReplay, Display, TEXT("Final state checksum %08x"), WorldChecksum);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	LoadedObjects.Empty();
+
+	return 0;
+}
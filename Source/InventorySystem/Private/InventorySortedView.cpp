@@ -0,0 +1,416 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventorySortedView.h"
+
+#include "InventorySystemComponent.h"
+#include "Item.h"
+
+UInventorySortedView* UInventorySortedView::CreateSortedView(UInventorySystemComponent* InventorySystemComponent, EInventoryViewSortKey SortKey, const FPrimaryAssetType& TypeFilter, bool bDescending)
+{
+	if(!InventorySystemComponent)
+	{
+		return nullptr;
+	}
+
+	UInventorySortedView* View = NewObject<UInventorySortedView>(InventorySystemComponent);
+	View->InventorySystemComponent = InventorySystemComponent;
+	View->SortKey = SortKey;
+	View->TypeFilter = TypeFilter;
+	View->bDescending = bDescending;
+
+	TArray<UItem*> Items;
+	InventorySystemComponent->GetInventoryItems(TypeFilter, Items);
+
+	View->Entries.Reserve(Items.Num());
+	View->EntryIndices.Reserve(Items.Num());
+	for(UItem* Item : Items)
+	{
+		const int32 EntryIndex = View->AllocateEntry(Item);
+		View->SnapshotSortKeys(View->Entries[EntryIndex], InventorySystemComponent->GetItemStackCount(Item));
+		View->LinkEntry(EntryIndex);
+	}
+
+	InventorySystemComponent->GetOnItemChangedDelegate().AddDynamic(View, &UInventorySortedView::HandleItemChanged);
+	UItem::OnItemSortKeysChanged().AddUObject(View, &UInventorySortedView::HandleItemSortKeysChanged);
+	return View;
+}
+
+void UInventorySortedView::Release()
+{
+	if(UInventorySystemComponent* Component = InventorySystemComponent.Get())
+	{
+		Component->GetOnItemChangedDelegate().RemoveDynamic(this, &UInventorySortedView::HandleItemChanged);
+	}
+
+	UItem::OnItemSortKeysChanged().RemoveAll(this);
+	InventorySystemComponent.Reset();
+}
+
+int32 UInventorySortedView::Num() const
+{
+	return GetSubtreeSize(RootEntry);
+}
+
+UItem* UInventorySortedView::GetItemAt(int32 Index) const
+{
+	if(Index < 0 || Index >= Num())
+	{
+		return nullptr;
+	}
+
+	int32 EntryIndex = RootEntry;
+	while(EntryIndex != INDEX_NONE)
+	{
+		const FInventoryViewEntry& Entry = Entries[EntryIndex];
+		const int32 LeftSize = GetSubtreeSize(Entry.Left);
+
+		if(Index == LeftSize)
+		{
+			return Entry.Item;
+		}
+
+		if(Index < LeftSize)
+		{
+			EntryIndex = Entry.Left;
+		}
+		else
+		{
+			Index -= LeftSize + 1;
+			EntryIndex = Entry.Right;
+		}
+	}
+
+	return nullptr;
+}
+
+int32 UInventorySortedView::IndexOf(UItem* Item) const
+{
+	const int32* EntryIndex = EntryIndices.Find(Item);
+	return EntryIndex ? GetRowIndex(*EntryIndex) : INDEX_NONE;
+}
+
+int32 UInventorySortedView::GetPage(int32 PageIndex, int32 PageSize, TArray<UItem*>& OutItems) const
+{
+	if(PageIndex < 0 || PageSize <= 0)
+	{
+		return 0;
+	}
+
+	const int32 First = PageIndex * PageSize;
+	const int32 Count = FMath::Clamp(Num() - First, 0, PageSize);
+	if(Count == 0)
+	{
+		return 0;
+	}
+
+	/* Descend to the first row of the page, remembering every entry we passed on its left as those come next in order */
+	TArray<int32, TInlineAllocator<64>> Pending;
+	int32 EntryIndex = RootEntry;
+	int32 Index = First;
+
+	while(EntryIndex != INDEX_NONE)
+	{
+		const FInventoryViewEntry& Entry = Entries[EntryIndex];
+		const int32 LeftSize = GetSubtreeSize(Entry.Left);
+
+		if(Index <= LeftSize)
+		{
+			Pending.Push(EntryIndex);
+			if(Index == LeftSize)
+			{
+				break;
+			}
+
+			EntryIndex = Entry.Left;
+		}
+		else
+		{
+			Index -= LeftSize + 1;
+			EntryIndex = Entry.Right;
+		}
+	}
+
+	OutItems.Reserve(OutItems.Num() + Count);
+	for(int32 Row = 0; Row < Count; Row++)
+	{
+		const FInventoryViewEntry& Entry = Entries[Pending.Pop(EAllowShrinking::No)];
+		OutItems.Add(Entry.Item);
+
+		for(int32 Child = Entry.Right; Child != INDEX_NONE; Child = Entries[Child].Left)
+		{
+			Pending.Push(Child);
+		}
+	}
+
+	return Count;
+}
+
+void UInventorySortedView::RefreshItem(UItem* Item)
+{
+	TArray<FInventoryViewChange, TInlineAllocator<2>> Changes;
+	UpdateItem(Item, Changes);
+
+	if(!Changes.IsEmpty())
+	{
+		OnViewChanged.Broadcast(TArray<FInventoryViewChange>(Changes));
+	}
+}
+
+void UInventorySortedView::BeginDestroy()
+{
+	Release();
+	Super::BeginDestroy();
+}
+
+void UInventorySortedView::HandleItemChanged(UItem* Item, EInventorySlotChangeType ChangeType)
+{
+	RefreshItem(Item);
+}
+
+void UInventorySortedView::HandleItemSortKeysChanged(UItem* Item)
+{
+	// A new type can also move the item into or out of our filter
+	RefreshItem(Item);
+}
+
+void UInventorySortedView::UpdateItem(UItem* Item, TArray<FInventoryViewChange, TInlineAllocator<2>>& OutChanges)
+{
+	UInventorySystemComponent* Component = InventorySystemComponent.Get();
+	if(!Component || !Item)
+	{
+		return;
+	}
+
+	const int32 NewStackCount = PassesFilter(Item) ? Component->GetItemStackCount(Item) : 0;
+	const int32* FoundEntry = EntryIndices.Find(Item);
+
+	if(!FoundEntry)
+	{
+		if(NewStackCount > 0)
+		{
+			const int32 EntryIndex = AllocateEntry(Item);
+			SnapshotSortKeys(Entries[EntryIndex], NewStackCount);
+			OutChanges.Emplace(EInventoryViewChangeType::Insert, LinkEntry(EntryIndex), Item);
+		}
+
+		return;
+	}
+
+	const int32 EntryIndex = *FoundEntry;
+	const int32 OldRow = GetRowIndex(EntryIndex);
+	RootEntry = UnlinkEntry(RootEntry, EntryIndex);
+
+	if(NewStackCount <= 0)
+	{
+		FreeEntry(EntryIndex);
+		OutChanges.Emplace(EInventoryViewChangeType::Remove, OldRow, Item);
+		return;
+	}
+
+	SnapshotSortKeys(Entries[EntryIndex], NewStackCount);
+	const int32 NewRow = LinkEntry(EntryIndex);
+
+	if(NewRow == OldRow)
+	{
+		OutChanges.Emplace(EInventoryViewChangeType::Update, OldRow, Item);
+	}
+	else
+	{
+		OutChanges.Emplace(EInventoryViewChangeType::Remove, OldRow, Item);
+		OutChanges.Emplace(EInventoryViewChangeType::Insert, NewRow, Item);
+	}
+}
+
+bool UInventorySortedView::PassesFilter(const UItem* Item) const
+{
+	return Item && (!TypeFilter.IsValid() || Item->GetItemType() == TypeFilter);
+}
+
+void UInventorySortedView::SnapshotSortKeys(FInventoryViewEntry& Entry, int32 StackCount) const
+{
+	Entry.StackCount = StackCount;
+	Entry.ObjectName = Entry.Item->GetFName();
+
+	switch(SortKey)
+	{
+	case EInventoryViewSortKey::Name:
+		Entry.SortName = Entry.Item->GetItemName();
+		break;
+	case EInventoryViewSortKey::Type:
+		Entry.SortName = Entry.Item->GetItemType().GetName();
+		break;
+	case EInventoryViewSortKey::StackCount:
+		Entry.SortName = NAME_None;
+		break;
+	}
+}
+
+bool UInventorySortedView::IsOrderedBefore(const FInventoryViewEntry& A, const FInventoryViewEntry& B) const
+{
+	int32 Result = 0;
+	if(SortKey == EInventoryViewSortKey::StackCount)
+	{
+		Result = A.StackCount < B.StackCount ? -1 : (A.StackCount > B.StackCount ? 1 : 0);
+	}
+	else
+	{
+		Result = A.SortName.Compare(B.SortName);
+	}
+
+	if(Result == 0)
+	{
+		Result = A.ObjectName.Compare(B.ObjectName);
+	}
+
+	if(Result == 0)
+	{
+		Result = A.Item < B.Item ? -1 : (A.Item > B.Item ? 1 : 0);
+	}
+
+	return bDescending ? Result > 0 : Result < 0;
+}
+
+int32 UInventorySortedView::GetSubtreeSize(int32 EntryIndex) const
+{
+	return EntryIndex != INDEX_NONE ? Entries[EntryIndex].Size : 0;
+}
+
+void UInventorySortedView::UpdateSubtreeSize(int32 EntryIndex)
+{
+	FInventoryViewEntry& Entry = Entries[EntryIndex];
+	Entry.Size = 1 + GetSubtreeSize(Entry.Left) + GetSubtreeSize(Entry.Right);
+}
+
+void UInventorySortedView::Split(int32 EntryIndex, const FInventoryViewEntry& Key, int32& OutLeft, int32& OutRight)
+{
+	if(EntryIndex == INDEX_NONE)
+	{
+		OutLeft = INDEX_NONE;
+		OutRight = INDEX_NONE;
+		return;
+	}
+
+	if(IsOrderedBefore(Entries[EntryIndex], Key))
+	{
+		int32 SplitLeft;
+		Split(Entries[EntryIndex].Right, Key, SplitLeft, OutRight);
+		Entries[EntryIndex].Right = SplitLeft;
+		OutLeft = EntryIndex;
+	}
+	else
+	{
+		int32 SplitRight;
+		Split(Entries[EntryIndex].Left, Key, OutLeft, SplitRight);
+		Entries[EntryIndex].Left = SplitRight;
+		OutRight = EntryIndex;
+	}
+
+	UpdateSubtreeSize(EntryIndex);
+}
+
+int32 UInventorySortedView::Merge(int32 Left, int32 Right)
+{
+	if(Left == INDEX_NONE || Right == INDEX_NONE)
+	{
+		return Left != INDEX_NONE ? Left : Right;
+	}
+
+	if(Entries[Left].Priority > Entries[Right].Priority)
+	{
+		Entries[Left].Right = Merge(Entries[Left].Right, Right);
+		UpdateSubtreeSize(Left);
+		return Left;
+	}
+
+	Entries[Right].Left = Merge(Left, Entries[Right].Left);
+	UpdateSubtreeSize(Right);
+	return Right;
+}
+
+int32 UInventorySortedView::LinkEntry(int32 EntryIndex)
+{
+	FInventoryViewEntry& Entry = Entries[EntryIndex];
+	Entry.Left = INDEX_NONE;
+	Entry.Right = INDEX_NONE;
+	Entry.Size = 1;
+
+	int32 Before;
+	int32 After;
+	Split(RootEntry, Entries[EntryIndex], Before, After);
+
+	const int32 Row = GetSubtreeSize(Before);
+	RootEntry = Merge(Merge(Before, EntryIndex), After);
+	return Row;
+}
+
+int32 UInventorySortedView::UnlinkEntry(int32 Subtree, int32 EntryIndex)
+{
+	if(Subtree == EntryIndex)
+	{
+		return Merge(Entries[Subtree].Left, Entries[Subtree].Right);
+	}
+
+	if(IsOrderedBefore(Entries[EntryIndex], Entries[Subtree]))
+	{
+		Entries[Subtree].Left = UnlinkEntry(Entries[Subtree].Left, EntryIndex);
+	}
+	else
+	{
+		Entries[Subtree].Right = UnlinkEntry(Entries[Subtree].Right, EntryIndex);
+	}
+
+	UpdateSubtreeSize(Subtree);
+	return Subtree;
+}
+
+int32 UInventorySortedView::GetRowIndex(int32 EntryIndex) const
+{
+	const FInventoryViewEntry& Key = Entries[EntryIndex];
+	int32 Row = 0;
+
+	for(int32 Current = RootEntry; Current != INDEX_NONE;)
+	{
+		if(Current == EntryIndex)
+		{
+			return Row + GetSubtreeSize(Key.Left);
+		}
+
+		if(IsOrderedBefore(Key, Entries[Current]))
+		{
+			Current = Entries[Current].Left;
+		}
+		else
+		{
+			Row += GetSubtreeSize(Entries[Current].Left) + 1;
+			Current = Entries[Current].Right;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+int32 UInventorySortedView::AllocateEntry(UItem* Item)
+{
+	const int32 EntryIndex = FreeEntries.IsEmpty() ? Entries.AddDefaulted() : FreeEntries.Pop(EAllowShrinking::No);
+
+	// Xorshift, the priorities only need to be independent of the sort order
+	PrioritySeed ^= PrioritySeed << 13;
+	PrioritySeed ^= PrioritySeed >> 17;
+	PrioritySeed ^= PrioritySeed << 5;
+
+	FInventoryViewEntry& Entry = Entries[EntryIndex];
+	Entry = FInventoryViewEntry();
+	Entry.Item = Item;
+	Entry.Priority = PrioritySeed;
+
+	EntryIndices.Add(Item, EntryIndex);
+	return EntryIndex;
+}
+
+void UInventorySortedView::FreeEntry(int32 EntryIndex)
+{
+	EntryIndices.Remove(Entries[EntryIndex].Item);
+	Entries[EntryIndex] = FInventoryViewEntry();
+	FreeEntries.Push(EntryIndex);
+}
@@ -3,6 +3,131 @@
 
 #include "InventorySystemComponent.h"
 
+#include "InventoryActorPoolSubsystem.h"
+#include "InventoryCommandSubsystem.h"
+#include "InventoryCooldownSubsystem.h"
+#include "InventoryItemRegistry.h"
+#include "InventoryTrace.h"
+#include "Algo/Reverse.h"
+#include "Engine/World.h"
+#include "Misc/ScopeRWLock.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_STATS_GROUP(TEXT("InventorySystem"), STATGROUP_InventorySystem, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Flush Deferred Events"), STAT_InventoryFlushDeferredEvents, STATGROUP_InventorySystem);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Broadcasts Saved"), STAT_InventoryBroadcastsSaved, STATGROUP_InventorySystem);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Version Conflicts"), STAT_InventoryVersionConflicts, STATGROUP_InventorySystem);
+
+namespace InventorySystemComponent
+{
+	/* Prints the largest inventories in a world and a histogram of inventory sizes
+	 * Usage: Inventory.MemReport [TopN]
+	 */
+	static void DumpMemoryReport(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		int32 TopN = 10;
+		if(Args.Num() > 0)
+		{
+			TopN = FMath::Max(0, FCString::Atoi(*Args[0]));
+		}
+
+		TArray<TPair<const UInventorySystemComponent*, FInventoryMemoryStats>> Entries;
+		FInventoryMemoryStats Total;
+
+		// Bucket N holds inventories with [2^(N-1), 2^N) items, bucket 0 holds empty inventories
+		constexpr int32 NumBuckets = 12;
+		int32 ItemHistogram[NumBuckets] = {};
+		int32 EquipmentHistogram[NumBuckets] = {};
+
+		auto GetBucket = [](int32 Count)
+		{
+			return Count <= 0 ? 0 : FMath::Min(NumBuckets - 1, (int32)FMath::FloorLog2(Count) + 1);
+		};
+
+		for(TObjectIterator<UInventorySystemComponent> It; It; ++It)
+		{
+			const UInventorySystemComponent* Component = *It;
+			if(Component->IsTemplate() || (World && Component->GetWorld() != World))
+			{
+				continue;
+			}
+
+			const FInventoryMemoryStats Stats = Component->GetMemoryStats();
+			Total.NumItems += Stats.NumItems;
+			Total.NumEquipmentSlots += Stats.NumEquipmentSlots;
+			Total.SlotBytes += Stats.SlotBytes;
+			Total.EquipmentBytes += Stats.EquipmentBytes;
+			Total.DelegateBytes += Stats.DelegateBytes;
+			Total.StateDataBytes += Stats.StateDataBytes;
+
+			ItemHistogram[GetBucket(Stats.NumItems)]++;
+			EquipmentHistogram[GetBucket(Stats.NumEquipmentSlots)]++;
+			Entries.Emplace(Component, Stats);
+		}
+
+		Entries.Sort([](const TPair<const UInventorySystemComponent*, FInventoryMemoryStats>& A, const TPair<const UInventorySystemComponent*, FInventoryMemoryStats>& B)
+		{
+			return A.Value.GetTotalBytes() > B.Value.GetTotalBytes();
+		});
+
+		Ar.Logf(TEXT("Inventory components: %d, total %lld bytes (slots %lld, equipment %lld, delegates %lld, state data %lld)"),
+			Entries.Num(), Total.GetTotalBytes(), Total.SlotBytes, Total.EquipmentBytes, Total.DelegateBytes, Total.StateDataBytes);
+
+		Ar.Logf(TEXT("Top %d components by footprint:"), FMath::Min(TopN, Entries.Num()));
+		for(int32 i = 0; i < Entries.Num() && i < TopN; i++)
+		{
+			const FInventoryMemoryStats& Stats = Entries[i].Value;
+			Ar.Logf(TEXT("  %8lld bytes  items %4d  equipment %3d  (slots %lld, equipment %lld, delegates %lld, state data %lld)  %s"),
+				Stats.GetTotalBytes(), Stats.NumItems, Stats.NumEquipmentSlots, Stats.SlotBytes, Stats.EquipmentBytes,
+				Stats.DelegateBytes, Stats.StateDataBytes, *Entries[i].Key->GetPathName());
+		}
+
+		Ar.Logf(TEXT("Inventory size histogram (items / equipment slots):"));
+		for(int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+		{
+			if(!ItemHistogram[Bucket] && !EquipmentHistogram[Bucket])
+			{
+				continue;
+			}
+
+			const int32 Min = Bucket == 0 ? 0 : 1 << (Bucket - 1);
+			const int32 Max = Bucket == 0 ? 0 : (Bucket == NumBuckets - 1 ? MAX_int32 : (1 << Bucket) - 1);
+			Ar.Logf(TEXT("  [%5d - %5d]  %6d / %6d"), Min, Max, ItemHistogram[Bucket], EquipmentHistogram[Bucket]);
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldArgsAndOutputDevice MemReportCommand(
+		TEXT("Inventory.MemReport"),
+		TEXT("Dumps the top N inventory components by memory footprint and a histogram of inventory sizes. Usage: Inventory.MemReport [TopN]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&DumpMemoryReport));
+}
+
+UInventorySystemComponent::UInventorySystemComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	EventDispatchMode = EInventoryEventDispatchMode::Immediate;
+	EventFlushTickGroup = TG_PostUpdateWork;
+	PendingBroadcastCount = 0;
+	BroadcastsSavedLastFlush = 0;
+	TraceScopeDepth = 0;
+
+	bPinItemsInRegistry = false;
+	bItemsPinned = false;
+	bMirrorLegacyMaps = true;
+	bSpawnEquippedItemInstances = false;
+	InventoryCore.GetEventSink().Owner = this;
+	NumOptionalObjectReferences = 0;
+
+	ChangeJournalCapacity = 1024;
+	InventoryVersion = 0;
+	BroadcastInventoryVersion = 0;
+	ChangeJournalStartVersion = 0;
+	CachedChangesSinceVersion = INDEX_NONE;
+	CachedChangesToVersion = INDEX_NONE;
+}
+
 AActor* UInventorySystemComponent::GetOwningActor() const
 {
 	return OwningActor;
@@ -15,30 +140,16 @@ AActor* UInventorySystemComponent::GetAvatarActor() const
 
 bool UInventorySystemComponent::AddItem(UItem* Item, int StackCount, bool bAutoEquip)
 {
+	FInventoryTraceScope TraceScope(this, bAutoEquip ? EInventoryTraceOp::AddItemAndEquip : EInventoryTraceOp::AddItem, Item, StackCount);
+
 	if(!Item || StackCount <= 0)
 	{
 		return false;
 	}
 
-	FInventorySlotData OldSlot;
-	GetInventorySlotForItem(Item, OldSlot);
-
-	FInventorySlotData NewSlot = OldSlot;
-	NewSlot.UpdateSlotData(FInventorySlotData(StackCount), Item->GetMaxStackCount());
-
-	/* If our data changed after trying to update */
-	if(NewSlot != OldSlot)
+	/* If our stack count changed after trying to update */
+	if(InventoryCore.AddItem(Item, StackCount) != 0)
 	{
-		InventoryMap.Add(Item, NewSlot);
-
-		/* If we have a delegate listening for this items stack count to change, broadcast to it the old and new stack values */
-		if(ItemStackCountChangedMap.Find(Item))
-		{
-			ItemStackCountChangedMap.FindChecked(Item).Broadcast(OldSlot.StackCount, NewSlot.StackCount);
-		}
-
-		OnItemChanged.Broadcast(Item, OldSlot.StackCount == 0 ? EInventorySlotChangeType::Added : EInventorySlotChangeType::StackChange);
-
 		if(bAutoEquip)
 		{
 			TryEquipItem(Item);
@@ -52,59 +163,25 @@ bool UInventorySystemComponent::AddItem(UItem* Item, int StackCount, bool bAutoE
 
 bool UInventorySystemComponent::RemoveItem(UItem* Item, int StackCount)
 {
-	if(!Item)
-	{
-		return false;
-	}
-
-	FInventorySlotData OldSlot;
-	GetInventorySlotForItem(Item, OldSlot);
-
-	if(!OldSlot.IsValid())
-	{
-		return false;
-	}
-
-	FInventorySlotData NewSlot = OldSlot;
-
-	NewSlot.StackCount = StackCount <= 0 ? 0 : NewSlot.StackCount - StackCount;
-
-	if(NewSlot.StackCount > 0)
-	{
-		InventoryMap.Add(Item, NewSlot);
-		OnItemChanged.Broadcast(Item, EInventorySlotChangeType::StackChange);
-
-		if(ItemStackCountChangedMap.Find(Item))
-		{
-			ItemStackCountChangedMap[Item].Broadcast(OldSlot.StackCount, NewSlot.StackCount);
-		}
-	}
-	else
-	{
-		InventoryMap.Remove(Item);
-		OnItemChanged.Broadcast(Item, EInventorySlotChangeType::Removed);
-	}
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::RemoveItem, Item, StackCount);
 
-	return true;
+	return InventoryCore.RemoveItem(Item, StackCount) > 0;
 }
 
 bool UInventorySystemComponent::SetItemStateData(UItem* Item, FItemStateData ItemStateData)
 {
-	FInventorySlotData Slot;
-	GetInventorySlotForItem(Item, Slot);
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::SetItemStateData, Item, 0, FEquippedSlot(), &ItemStateData);
 
-	if(Slot.IsValid())
+	return InventoryCore.ModifySlot(Item, [&ItemStateData](FInventorySlotData& Slot)
 	{
 		Slot.ItemData = ItemStateData;
-		InventoryMap.Add(Item, Slot);
-		return true;
-	}
-
-	return false;
+	});
 }
 
 FItemStateData UInventorySystemComponent::GetItemStateData(UItem* Item)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetItemStateData, Item);
+
 	FInventorySlotData Slot;
 	GetInventorySlotForItem(Item, Slot);
 	return Slot.ItemData;
@@ -112,52 +189,72 @@ FItemStateData UInventorySystemComponent::GetItemStateData(UItem* Item)
 
 bool UInventorySystemComponent::GetInventoryItems(FPrimaryAssetType ItemType, TArray<UItem*>& OutItems)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetInventoryItems, nullptr, 0, FEquippedSlot(ItemType, INDEX_NONE));
+
+	const FInventoryStorage& ItemStorage = InventoryCore.GetItemStorage();
+
 	if(!ItemType.IsValid())
 	{
-		InventoryMap.GetKeys(OutItems);
+		ItemStorage.GetKeys(OutItems);
 		return !OutItems.IsEmpty();
 	}
 
-	for(TPair<UItem*, FInventorySlotData>& Pair : InventoryMap)
+	InventoryCore.GetItems(OutItems, [&ItemType](const UItem* Item)
 	{
-		if(Pair.Key && Pair.Key->GetItemType() == ItemType)
-		{
-			OutItems.Add(Pair.Key);
-		}
-	}
+		return Item && Item->GetItemType() == ItemType;
+	});
 
 	return !OutItems.IsEmpty();
 }
 
 int UInventorySystemComponent::GetItemStackCount(const UItem* Item)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetItemStackCount, Item);
+
 	if(!Item)
 	{
 		return 0;
 	}
 
-	if(const FInventorySlotData* SlotData = InventoryMap.Find(Item))
+	return InventoryCore.GetStackCount(Item);
+}
+
+TMap<UItem*, FInventorySlotData> UInventorySystemComponent::GetInventoryMap() const
+{
+	const FInventoryStorage& ItemStorage = InventoryCore.GetItemStorage();
+
+	TMap<UItem*, FInventorySlotData> ItemMap;
+	ItemMap.Reserve(ItemStorage.Num());
+
+	for(int32 Index = 0; Index < ItemStorage.Num(); Index++)
 	{
-		return SlotData->StackCount;
+		ItemMap.Add(ItemStorage.GetKeyAt(Index), ItemStorage.GetValueAt(Index));
 	}
 
-	return 0;
+	return ItemMap;
 }
 
 void UInventorySystemComponent::InitInventorySystemComponent()
 {
-	// Remove any items before adding our defaults
-	for(TPair<UItem*, FInventorySlotData>& Pair : InventoryMap)
+	FInventoryStorage& ItemStorage = InventoryCore.GetItemStorage();
+
+	// Remove any items before adding our defaults, walk backwards as removal swaps the last item into the removed index
+	for(int32 Index = ItemStorage.Num() - 1; Index >= 0; Index--)
 	{
-		if(Pair.Key)
+		if(UItem* Item = ItemStorage.GetKeyAt(Index))
+		{
+			RemoveItem(Item, -1);
+		}
+		else
 		{
-			RemoveItem(Pair.Key, -1);
+			ItemStorage.RemoveAt(Index);
+			InventoryMap.Remove(nullptr);
 		}
 	}
 
 	if(!DefaultEquipmentSlots.IsEmpty())
 	{
-		EquipmentMap.Reserve(DefaultEquipmentSlots.Num());
+		InventoryCore.GetEquipmentStorage().Reserve(DefaultEquipmentSlots.Num());
 
 		/* Loop through our map of slot types to slot amounts
 		 * Add a new equipment slot for each slot up the total amount
@@ -166,7 +263,7 @@ void UInventorySystemComponent::InitInventorySystemComponent()
 		{
 			for(int i = 0; i < Pair.Value; i++)
 			{
-				EquipmentMap.Add(FEquippedSlot(Pair.Key, i));
+				AddEquipmentSlot(FEquippedSlot(Pair.Key, i));
 			}
 		}
 	}
@@ -180,12 +277,13 @@ void UInventorySystemComponent::InitInventorySystemComponent()
 
 bool UInventorySystemComponent::HasItem(const UItem* Item)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::HasItem, Item);
+
 	/* Return false if we pass in no item */
 	if (!Item) return false;
 
 	/* Check if any of our inventory slots contains a reference to the data asset */
-	const FInventorySlotData* Data = InventoryMap.Find(Item);
-	return Data ? true : false;
+	return InventoryCore.HasItem(Item);
 }
 
 FOnItemChanged& UInventorySystemComponent::GetOnItemChangedDelegate()
@@ -204,10 +302,219 @@ void UInventorySystemComponent::InitActorInfo(AActor* InOwningActor, AActor* InA
 	AvatarActor = InAvatarActor;
 }
 
+FInventoryMemoryStats UInventorySystemComponent::GetMemoryStats() const
+{
+	FInventoryMemoryStats Stats;
+	Stats.NumItems = InventoryCore.GetItemStorage().Num();
+	Stats.NumEquipmentSlots = InventoryCore.GetEquipmentStorage().Num();
+
+	// State data is stored with each slot, split it out of any heap allocation so we can see what it costs on its own
+	const int64 InventoryBytes = InventoryCore.GetItemStorage().GetAllocatedSize();
+	Stats.StateDataBytes = FMath::Min(InventoryBytes, (int64)InventoryCore.GetItemStorage().Num() * (int64)sizeof(FItemStateData));
+	Stats.SlotBytes = InventoryBytes - Stats.StateDataBytes + InventoryMap.GetAllocatedSize();
+	Stats.EquipmentBytes = InventoryCore.GetEquipmentStorage().GetAllocatedSize() + EquipmentMap.GetAllocatedSize();
+
+	Stats.DelegateBytes = ItemStackCountChangedMap.GetAllocatedSize();
+	for(const FOnItemStackCountChanged& Delegate : ItemStackCountChangedMap.GetValues())
+	{
+		Stats.DelegateBytes += Delegate.GetAllocatedSize();
+	}
+
+	Stats.DelegateBytes += OnItemChanged.GetAllocatedSize();
+	Stats.DelegateBytes += OnEquipmentSlotChanged.GetAllocatedSize();
+	Stats.DelegateBytes += OnEquipmentSlotUsed.GetAllocatedSize();
+	Stats.DelegateBytes += OnEquipmentLoadoutApplied.GetAllocatedSize();
+	Stats.DelegateBytes += OnEquipmentSlotUseStateChanged.GetAllocatedSize();
+	Stats.DelegateBytes += OnInventoryChangesAvailable.GetAllocatedSize();
+	Stats.DelegateBytes += ChangeJournal.GetAllocatedSize() + CachedChanges.GetAllocatedSize() + InventoryViewers.GetAllocatedSize();
+
+	Stats.EquipmentBytes += EquipmentSlotVersions.GetAllocatedSize();
+	Stats.EquipmentBytes += EquippedItemInstances.GetAllocatedSize();
+
+	Stats.EquipmentBytes += EquipmentSlotUseStates.GetAllocatedSize();
+
+	Stats.EquipmentBytes += EquipmentLoadouts.GetAllocatedSize();
+	for(const TPair<FName, FEquipmentLoadout>& Pair : EquipmentLoadouts)
+	{
+		Stats.EquipmentBytes += Pair.Value.Slots.GetAllocatedSize();
+	}
+
+	return Stats;
+}
+
+void UInventorySystemComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetMemoryStats().GetTotalBytes());
+}
+
+void UInventorySystemComponent::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UInventorySystemComponent* This = CastChecked<UInventorySystemComponent>(InThis);
+
+	/* Pinned items are kept alive by the item registry, only the optional objects in our state data are ours to report.
+	 * Once the registry is gone at engine shutdown it no longer holds them, so we report everything again */
+	const bool bItemsArePinned = This->bItemsPinned && UInventoryItemRegistry::Get();
+
+	if(!bItemsArePinned)
+	{
+		This->InventoryCore.AddReferencedObjects(Collector, This);
+	}
+	else if(This->NumOptionalObjectReferences > 0)
+	{
+		This->InventoryCore.AddSlotReferencedObjects(Collector, This);
+	}
+
+	for(int32 Index = 0; Index < This->ItemStackCountChangedMap.Num(); Index++)
+	{
+		Collector.AddReferencedObject(This->ItemStackCountChangedMap.GetKeyAtForReferenceCollection(Index), This);
+	}
+
+	for(int32 Index = 0; Index < This->PendingItemChanges.Num(); Index++)
+	{
+		Collector.AddReferencedObject(This->PendingItemChanges.GetKeyAtForReferenceCollection(Index), This);
+	}
+
+	for(UItem*& Item : This->PendingEquipmentChanges.GetValues())
+	{
+		Collector.AddReferencedObject(Item, This);
+	}
+
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+void UInventorySystemComponent::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Templates never store items of their own, only the instances created from them pin
+	bItemsPinned = bPinItemsInRegistry && !HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject) && UInventoryItemRegistry::Get();
+}
+
+void UInventorySystemComponent::BeginDestroy()
+{
+	if(bItemsPinned)
+	{
+		FInventoryStorage& ItemStorage = InventoryCore.GetItemStorage();
+		FEquipmentStorage& EquipmentStorage = InventoryCore.GetEquipmentStorage();
+
+		for(UItem* Item : ItemStorage.GetKeys())
+		{
+			UnpinItem(Item);
+		}
+
+		for(UItem* Item : EquipmentStorage.GetValues())
+		{
+			UnpinItem(Item);
+		}
+
+		ItemStorage.Empty();
+		EquipmentStorage.Empty();
+		InventoryMap.Empty();
+		EquipmentMap.Empty();
+	}
+
+	Super::BeginDestroy();
+}
+
+void UInventorySystemComponent::PinItem(UItem* Item)
+{
+	if(!bItemsPinned || !Item)
+	{
+		return;
+	}
+
+	if(UInventoryItemRegistry* ItemRegistry = UInventoryItemRegistry::Get())
+	{
+		ItemRegistry->PinItem(Item);
+	}
+}
+
+void UInventorySystemComponent::UnpinItem(UItem* Item)
+{
+	if(!bItemsPinned || !Item)
+	{
+		return;
+	}
+
+	if(UInventoryItemRegistry* ItemRegistry = UInventoryItemRegistry::Get())
+	{
+		ItemRegistry->UnpinItem(Item);
+	}
+}
+
+void UInventorySystemComponent::HandleItemSlotChanged(UItem* Item, const FInventorySlotData& OldSlot, FInventorySlotData* NewSlot)
+{
+	const int32 NewStackCount = NewSlot ? NewSlot->StackCount : 0;
+	const int64 Version = RecordChange(Item, NewStackCount);
+
+	NumOptionalObjectReferences += (NewSlot && NewSlot->ItemData.OptionalObject ? 1 : 0) - (OldSlot.ItemData.OptionalObject ? 1 : 0);
+
+	if(!NewSlot)
+	{
+		UnpinItem(Item);
+	}
+	else
+	{
+		NewSlot->Version = Version;
+
+		if(OldSlot.StackCount <= 0)
+		{
+			PinItem(Item);
+		}
+	}
+
+	if(bMirrorLegacyMaps)
+	{
+		if(NewSlot)
+		{
+			InventoryMap.Add(Item, *NewSlot);
+		}
+		else
+		{
+			InventoryMap.Remove(Item);
+		}
+	}
+
+	if(OldSlot.StackCount != NewStackCount)
+	{
+		NotifyItemChanged(Item, OldSlot.StackCount, NewStackCount);
+	}
+}
+
+void UInventorySystemComponent::HandleEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem)
+{
+	UpdateEquippedItemInstance(EquippedSlot, NewItem);
+	PinItem(NewItem);
+	UnpinItem(OldItem);
+
+	EquipmentSlotVersions.FindOrAdd(EquippedSlot) = RecordChange(NewItem, 0, EquippedSlot);
+	MirrorEquipmentSlot(EquippedSlot, NewItem);
+}
+
+void UInventorySystemComponent::MirrorEquipmentSlot(const FEquippedSlot& EquippedSlot, UItem* Item)
+{
+	if(bMirrorLegacyMaps)
+	{
+		EquipmentMap.Add(EquippedSlot, Item);
+	}
+}
+
+void FInventorySystemComponentEventSink::OnItemSlotChanged(UItem* Item, const FInventorySlotData& OldSlot, FInventorySlotData* NewSlot)
+{
+	Owner->HandleItemSlotChanged(Item, OldSlot, NewSlot);
+}
+
+void FInventorySystemComponentEventSink::OnEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem)
+{
+	Owner->HandleEquipmentSlotChanged(EquippedSlot, OldItem, NewItem);
+}
+
 bool UInventorySystemComponent::GetInventorySlotForItem(UItem* Item, FInventorySlotData& InventorySlot)
 {
 
-	if(const FInventorySlotData* Slot = InventoryMap.Find(Item))
+	if(const FInventorySlotData* Slot = InventoryCore.FindSlot(Item))
 	{
 		InventorySlot = *Slot;
 		return true;
@@ -219,6 +526,8 @@ bool UInventorySystemComponent::GetInventorySlotForItem(UItem* Item, FInventoryS
 
 bool UInventorySystemComponent::TryEquipItem(UItem* Item, FEquippedSlot OptionalSlot)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::TryEquipItem, Item, 0, OptionalSlot);
+
 	if(!Item)
 	{
 		return false;
@@ -236,7 +545,7 @@ bool UInventorySystemComponent::TryEquipItem(UItem* Item, FEquippedSlot Optional
 		return false;
 	}
 
-	if(!EquipmentMap.Contains(Slot))
+	if(!InventoryCore.HasEquipmentSlot(Slot))
 	{
 		return false;
 	}
@@ -253,13 +562,21 @@ bool UInventorySystemComponent::TryEquipItem(UItem* Item, FEquippedSlot Optional
 
 bool UInventorySystemComponent::UseItemAtEquipmentSlot(const FEquippedSlot EquippedSlot)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::UseItemAtEquipmentSlot, nullptr, 0, EquippedSlot);
+
 	UItem* Item = GetItemAtEquipmentSlot(EquippedSlot);
-	if(!Item)
+	if(!Item || !CanUseItemAtEquipmentSlot(EquippedSlot))
 	{
 		return false;
 	}
 
-	OnEquipmentSlotUsed.Broadcast(EquippedSlot, Item);
+	StartEquipmentSlotCooldown(EquippedSlot, Item);
+
+	{
+		FInventoryTraceBroadcastScope BroadcastScope(this);
+		OnEquipmentSlotUsed.Broadcast(EquippedSlot, Item);
+	}
+
 	if(Item->ConsumeOnUse())
 	{
 		RemoveItem(Item);
@@ -270,89 +587,1066 @@ bool UInventorySystemComponent::UseItemAtEquipmentSlot(const FEquippedSlot Equip
 
 int UInventorySystemComponent::GetTotalEquipmentSlotsOfType(FPrimaryAssetType Type)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetTotalEquipmentSlotsOfType, nullptr, 0, FEquippedSlot(Type, INDEX_NONE));
+
 	if(!Type.IsValid())
 	{
 		return 0;
 	}
 
-	int HighestValue = -1;
+	return InventoryCore.GetHighestEquipmentSlotNumber(Type);
+}
+
+bool UInventorySystemComponent::AddEquipmentSlot(const FEquippedSlot& EquippedSlot)
+{
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::AddEquipmentSlot, nullptr, 0, EquippedSlot);
 
-	for(TPair<FEquippedSlot, UItem*>& Pair : EquipmentMap)
+	if(!EquippedSlot.IsValid() || !InventoryCore.AddEquipmentSlot(EquippedSlot))
 	{
-		if(Type == Pair.Key.SlotType)
-		{
-			if(Pair.Key.SlotNumber > HighestValue)
-			{
-				HighestValue = Pair.Key.SlotNumber;
-			}
-		}
+		return false;
+	}
+
+	EquipmentSlotVersions.Add(EquippedSlot, RecordChange(nullptr, 0, EquippedSlot));
+	MirrorEquipmentSlot(EquippedSlot, nullptr);
+	return true;
+}
+
+bool UInventorySystemComponent::GetEquipmentSlots(TArray<FEquippedSlot>& OutSlots)
+{
+	InventoryCore.GetEquipmentStorage().GetKeys(OutSlots);
+	return !OutSlots.IsEmpty();
+}
+
+TMap<FEquippedSlot, UItem*> UInventorySystemComponent::GetEquipmentMap() const
+{
+	const FEquipmentStorage& EquipmentStorage = InventoryCore.GetEquipmentStorage();
+
+	TMap<FEquippedSlot, UItem*> SlotMap;
+	SlotMap.Reserve(EquipmentStorage.Num());
+
+	for(int32 Index = 0; Index < EquipmentStorage.Num(); Index++)
+	{
+		SlotMap.Add(EquipmentStorage.GetKeyAt(Index), EquipmentStorage.GetValueAt(Index));
 	}
 
-	return HighestValue;
+	return SlotMap;
 }
 
 UItem* UInventorySystemComponent::GetItemAtEquipmentSlot(const FEquippedSlot& EquippedSlot)
 {
-	UItem** FoundItem = EquipmentMap.Find(EquippedSlot);
-	return FoundItem ? *FoundItem : nullptr;
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetItemAtEquipmentSlot, nullptr, 0, EquippedSlot);
+
+	return InventoryCore.GetItemAtEquipmentSlot(EquippedSlot);
 }
 
 bool UInventorySystemComponent::IsItemEquipped(const UItem* Item, FEquippedSlot& EquippedSlot)
 {
-	if(!Item)
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::IsItemEquipped, Item);
+
+	if(!InventoryCore.FindEquippedSlot(Item, EquippedSlot))
 	{
 		EquippedSlot = FEquippedSlot();
 		return false;
 	}
 
-	for(const TPair<FEquippedSlot, UItem*>& Pair : EquipmentMap)
-	{
-		if(Pair.Value == Item)
-		{
-			EquippedSlot = Pair.Key;
-			return true;
-		}
-	}
-
-	EquippedSlot = FEquippedSlot();
-	return false;
+	return true;
 }
 
 bool UInventorySystemComponent::GetFirstAvailableEquipmentSlot(FPrimaryAssetType Type, FEquippedSlot& OutOpenSlot)
 {
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::GetFirstAvailableEquipmentSlot, nullptr, 0, FEquippedSlot(Type, INDEX_NONE));
+
 	if(!Type.IsValid())
 	{
 		return false;
 	}
 
-	for(TPair<FEquippedSlot, UItem*>& Slot : EquipmentMap)
+	if(!InventoryCore.FindEmptyEquipmentSlot(Type, OutOpenSlot))
 	{
-		FEquippedSlot& Key = Slot.Key;
-		if(Type == Key.SlotType && !Slot.Value)
-		{
-			OutOpenSlot = Slot.Key;
-			return true;
-		}
+		OutOpenSlot = FEquippedSlot();
+		return false;
 	}
 
-	OutOpenSlot = FEquippedSlot();
-	return false;
+	return true;
 }
 
 void UInventorySystemComponent::AddItemToEquipmentSlot(const FEquippedSlot& EquippedSlot, UItem* Item)
 {
-	EquipmentMap.Add(EquippedSlot, Item);
-	OnEquipmentSlotChanged.Broadcast(EquippedSlot, Item, EEquipmentSlotChangeType::Added);
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::AddItemToEquipmentSlot, Item, 0, EquippedSlot);
+
+	UItem* OldItem = SetItemInEquipmentSlot(EquippedSlot, Item);
+	NotifyEquipmentSlotChanged(EquippedSlot, OldItem, Item, EEquipmentSlotChangeType::Added);
 }
 
 void UInventorySystemComponent::RemoveItemFromEquipmentSlot(const FEquippedSlot& EquippedSlot)
 {
-	UItem* Item = *(EquipmentMap.Find(EquippedSlot));
-	EquipmentMap.Add(EquippedSlot, nullptr);
-	OnEquipmentSlotChanged.Broadcast(EquippedSlot, Item, EEquipmentSlotChangeType::Removed);
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::RemoveItemFromEquipmentSlot, nullptr, 0, EquippedSlot);
+
+	if(!InventoryCore.HasEquipmentSlot(EquippedSlot))
+	{
+		return;
+	}
+
+	UItem* OldItem = SetItemInEquipmentSlot(EquippedSlot, nullptr);
+	NotifyEquipmentSlotChanged(EquippedSlot, OldItem, nullptr, EEquipmentSlotChangeType::Removed);
 }
 
 FOnEquipmentSlotChanged& UInventorySystemComponent::GetEquipmentSlotChangedDelegate()
 {
 	return OnEquipmentSlotChanged;
 }
+
+UItem* UInventorySystemComponent::SetItemInEquipmentSlot(const FEquippedSlot& EquippedSlot, UItem* Item)
+{
+	// Slots created on demand by AddItemToEquipmentSlot are stamped on their first write even when it leaves them empty
+	const bool bIsNewSlot = !EquipmentSlotVersions.Contains(EquippedSlot);
+
+	UItem* OldItem = InventoryCore.SetItemInEquipmentSlot(EquippedSlot, Item);
+	if(OldItem == Item && bIsNewSlot)
+	{
+		EquipmentSlotVersions.Add(EquippedSlot, RecordChange(Item, 0, EquippedSlot));
+		MirrorEquipmentSlot(EquippedSlot, Item);
+	}
+
+	return OldItem;
+}
+
+bool UInventorySystemComponent::SaveEquipmentLoadout(FName LoadoutName)
+{
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::SaveEquipmentLoadout, LoadoutName);
+
+	if(LoadoutName.IsNone())
+	{
+		return false;
+	}
+
+	const FEquipmentStorage& EquipmentStorage = InventoryCore.GetEquipmentStorage();
+	FEquipmentLoadout& Loadout = EquipmentLoadouts.FindOrAdd(LoadoutName);
+	Loadout.Slots.Empty(EquipmentStorage.Num());
+
+	for(int32 Index = 0; Index < EquipmentStorage.Num(); Index++)
+	{
+		Loadout.Slots.Add(EquipmentStorage.GetKeyAt(Index), EquipmentStorage.GetValueAt(Index));
+	}
+
+	return true;
+}
+
+bool UInventorySystemComponent::ApplyEquipmentLoadout(FName LoadoutName)
+{
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::ApplyEquipmentLoadout, LoadoutName);
+
+	const FEquipmentLoadout* Loadout = EquipmentLoadouts.Find(LoadoutName);
+	if(!Loadout)
+	{
+		return false;
+	}
+
+	TArray<TPair<FEquippedSlot, UItem*>, TInlineAllocator<InlineEquipmentCapacity>> SlotItems;
+	TArray<UItem*, TInlineAllocator<InlineEquipmentCapacity>> PlacedItems;
+
+	/* Walk our own slots rather than the loadout's, slots the loadout does not know about are left as they are and keep their items */
+	const FEquipmentStorage& EquipmentStorage = InventoryCore.GetEquipmentStorage();
+	for(int32 Index = 0; Index < EquipmentStorage.Num(); Index++)
+	{
+		const FEquippedSlot& EquippedSlot = EquipmentStorage.GetKeyAt(Index);
+		if(UItem* const* LoadoutItem = Loadout->Slots.Find(EquippedSlot))
+		{
+			SlotItems.Emplace(EquippedSlot, *LoadoutItem);
+		}
+		else if(UItem* Item = EquipmentStorage.GetValueAt(Index))
+		{
+			PlacedItems.Add(Item);
+		}
+	}
+
+	/* Work out every slot's item before touching any of them, an item moving between slots must not be placed twice */
+	for(TPair<FEquippedSlot, UItem*>& SlotItem : SlotItems)
+	{
+		UItem*& Item = SlotItem.Value;
+		if(Item && (!SlotItem.Key.IsValidForItem(Item) || !HasItem(Item) || PlacedItems.Contains(Item)))
+		{
+			Item = nullptr;
+		}
+
+		if(Item)
+		{
+			PlacedItems.Add(Item);
+		}
+	}
+
+	/* Slots are written without OnEquipmentSlotChanged, OnEquipmentLoadoutApplied is the one event for the whole loadout.
+	 * Versions, pinning and item instances are still updated per slot by HandleEquipmentSlotChanged */
+	TArray<FEquippedSlot> ChangedSlots;
+	for(const TPair<FEquippedSlot, UItem*>& SlotItem : SlotItems)
+	{
+		// Item instances spawned for earlier slots may have removed the slot in the meantime
+		if(!InventoryCore.HasEquipmentSlot(SlotItem.Key) || GetItemAtEquipmentSlot(SlotItem.Key) == SlotItem.Value)
+		{
+			continue;
+		}
+
+		SetItemInEquipmentSlot(SlotItem.Key, SlotItem.Value);
+		ChangedSlots.Add(SlotItem.Key);
+	}
+
+	if(!ChangedSlots.IsEmpty())
+	{
+		NotifyEquipmentLoadoutApplied(LoadoutName, ChangedSlots);
+	}
+
+	return true;
+}
+
+bool UInventorySystemComponent::RemoveEquipmentLoadout(FName LoadoutName)
+{
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::RemoveEquipmentLoadout, LoadoutName);
+
+	return EquipmentLoadouts.Remove(LoadoutName) > 0;
+}
+
+bool UInventorySystemComponent::HasEquipmentLoadout(FName LoadoutName) const
+{
+	return EquipmentLoadouts.Contains(LoadoutName);
+}
+
+FOnEquipmentLoadoutApplied& UInventorySystemComponent::GetEquipmentLoadoutAppliedDelegate()
+{
+	return OnEquipmentLoadoutApplied;
+}
+
+bool UInventorySystemComponent::CanUseItemAtEquipmentSlot(const FEquippedSlot& EquippedSlot) const
+{
+	UItem* const* Item = InventoryCore.GetEquipmentStorage().Find(EquippedSlot);
+	if(!Item || !*Item)
+	{
+		return false;
+	}
+
+	const bool bIsLimited = (*Item)->GetUseCooldown() > 0.f || (*Item)->GetMaxCharges() > 0;
+	const UInventoryCooldownSubsystem* CooldownSubsystem = GetCooldownSubsystem();
+	if(!CooldownSubsystem)
+	{
+		return !bIsLimited;
+	}
+
+	const FEquipmentSlotUseState* UseState = FindEquipmentSlotUseState(EquippedSlot);
+	if(!UseState)
+	{
+		return true;
+	}
+
+	if(CooldownSubsystem->IsTimerActive(UseState->CooldownTimer))
+	{
+		return false;
+	}
+
+	return (*Item)->GetMaxCharges() <= 0 || UseState->Charges > 0;
+}
+
+float UInventorySystemComponent::GetEquipmentSlotCooldownRemaining(const FEquippedSlot& EquippedSlot) const
+{
+	const FEquipmentSlotUseState* UseState = FindEquipmentSlotUseState(EquippedSlot);
+	const UInventoryCooldownSubsystem* CooldownSubsystem = GetCooldownSubsystem();
+	return UseState && CooldownSubsystem ? CooldownSubsystem->GetRemainingTime(UseState->CooldownTimer) : 0.f;
+}
+
+int32 UInventorySystemComponent::GetEquipmentSlotCharges(const FEquippedSlot& EquippedSlot) const
+{
+	UItem* const* Item = InventoryCore.GetEquipmentStorage().Find(EquippedSlot);
+	if(!Item || !*Item || (*Item)->GetMaxCharges() <= 0)
+	{
+		return -1;
+	}
+
+	// Items start out full and are only tracked once a charge has been spent
+	const FEquipmentSlotUseState* UseState = FindEquipmentSlotUseState(EquippedSlot);
+	return UseState ? UseState->Charges : (*Item)->GetMaxCharges();
+}
+
+FOnEquipmentSlotUseStateChanged& UInventorySystemComponent::GetEquipmentSlotUseStateChangedDelegate()
+{
+	return OnEquipmentSlotUseStateChanged;
+}
+
+void UInventorySystemComponent::HandleCooldownTimerExpired(const FEquippedSlot& EquippedSlot, TObjectKey<UItem> ItemKey, EInventoryCooldownTimerType Type)
+{
+	const FEquipmentSlotUseStateKey UseStateKey(EquippedSlot, ItemKey);
+	FEquipmentSlotUseState* UseState = EquipmentSlotUseStates.Find(UseStateKey);
+	if(!UseState)
+	{
+		return;
+	}
+
+	UInventoryCooldownSubsystem* CooldownSubsystem = GetCooldownSubsystem();
+
+	// The item was destroyed while it was recovering, nobody can use it again
+	const UItem* Item = ItemKey.ResolveObjectPtr();
+	if(!Item)
+	{
+		if(CooldownSubsystem)
+		{
+			CooldownSubsystem->CancelTimer(UseState->CooldownTimer);
+			CooldownSubsystem->CancelTimer(UseState->ChargeRecoveryTimer);
+		}
+
+		EquipmentSlotUseStates.Remove(UseStateKey);
+		return;
+	}
+
+	if(Type == EInventoryCooldownTimerType::Cooldown)
+	{
+		UseState->CooldownTimer.Invalidate();
+	}
+	else
+	{
+		UseState->ChargeRecoveryTimer.Invalidate();
+		UseState->Charges = FMath::Min(UseState->Charges + 1, Item->GetMaxCharges());
+
+		// Keep recovering one charge at a time until the item is full again
+		if(UseState->Charges < Item->GetMaxCharges() && CooldownSubsystem)
+		{
+			UseState->ChargeRecoveryTimer = CooldownSubsystem->StartTimer(this, EquippedSlot, Item, EInventoryCooldownTimerType::ChargeRecovery, Item->GetChargeRecoveryTime());
+		}
+	}
+
+	const bool bOnCooldown = CooldownSubsystem && CooldownSubsystem->IsTimerActive(UseState->CooldownTimer);
+
+	// Nothing left to track, an item without state behaves as ready with full charges
+	if(!bOnCooldown && !UseState->ChargeRecoveryTimer.IsValid() && (Item->GetMaxCharges() <= 0 || UseState->Charges >= Item->GetMaxCharges()))
+	{
+		EquipmentSlotUseStates.Remove(UseStateKey);
+	}
+
+	// Items recovering outside of the slot do so silently, the slot reports the state of the item it holds
+	UItem* const* SlotItem = InventoryCore.GetEquipmentStorage().Find(EquippedSlot);
+	if(SlotItem && *SlotItem == Item)
+	{
+		NotifyEquipmentSlotUseStateChanged(EquippedSlot);
+	}
+}
+
+void UInventorySystemComponent::StartEquipmentSlotCooldown(const FEquippedSlot& EquippedSlot, const UItem* Item)
+{
+	const float UseCooldown = Item->GetUseCooldown();
+	const int32 MaxCharges = Item->GetMaxCharges();
+	if(UseCooldown <= 0.f && MaxCharges <= 0)
+	{
+		return;
+	}
+
+	// CanUseItemAtEquipmentSlot refuses items with a cooldown or charges while there is no subsystem to time them
+	UInventoryCooldownSubsystem* CooldownSubsystem = GetCooldownSubsystem();
+	if(!CooldownSubsystem)
+	{
+		return;
+	}
+
+	const FEquipmentSlotUseStateKey UseStateKey(EquippedSlot, Item);
+	const bool bIsNewState = !EquipmentSlotUseStates.Contains(UseStateKey);
+	FEquipmentSlotUseState& UseState = EquipmentSlotUseStates.FindOrAdd(UseStateKey);
+	if(bIsNewState)
+	{
+		UseState.Charges = MaxCharges;
+	}
+
+	if(MaxCharges > 0)
+	{
+		UseState.Charges--;
+		if(Item->GetChargeRecoveryTime() > 0.f && !CooldownSubsystem->IsTimerActive(UseState.ChargeRecoveryTimer))
+		{
+			UseState.ChargeRecoveryTimer = CooldownSubsystem->StartTimer(this, EquippedSlot, Item, EInventoryCooldownTimerType::ChargeRecovery, Item->GetChargeRecoveryTime());
+		}
+	}
+
+	if(UseCooldown > 0.f)
+	{
+		UseState.CooldownTimer = CooldownSubsystem->StartTimer(this, EquippedSlot, Item, EInventoryCooldownTimerType::Cooldown, UseCooldown);
+	}
+
+	NotifyEquipmentSlotUseStateChanged(EquippedSlot);
+}
+
+void UInventorySystemComponent::ClearEquipmentSlotUseStates()
+{
+	if(UInventoryCooldownSubsystem* CooldownSubsystem = GetCooldownSubsystem())
+	{
+		for(FEquipmentSlotUseState& UseState : EquipmentSlotUseStates.GetValues())
+		{
+			CooldownSubsystem->CancelTimer(UseState.CooldownTimer);
+			CooldownSubsystem->CancelTimer(UseState.ChargeRecoveryTimer);
+		}
+	}
+
+	EquipmentSlotUseStates.Empty();
+}
+
+const FEquipmentSlotUseState* UInventorySystemComponent::FindEquipmentSlotUseState(const FEquippedSlot& EquippedSlot) const
+{
+	UItem* const* Item = InventoryCore.GetEquipmentStorage().Find(EquippedSlot);
+	return Item && *Item ? EquipmentSlotUseStates.Find(FEquipmentSlotUseStateKey(EquippedSlot, *Item)) : nullptr;
+}
+
+void UInventorySystemComponent::NotifyEquipmentSlotUseStateChanged(const FEquippedSlot& EquippedSlot)
+{
+	if(EventDispatchMode == EInventoryEventDispatchMode::Immediate)
+	{
+		BroadcastEquipmentSlotUseStateChanged(EquippedSlot);
+		return;
+	}
+
+	// The flush reports the state the slot is in by then, one broadcast per slot is enough
+	PendingEquipmentUseStateChanges.AddUnique(EquippedSlot);
+	PendingBroadcastCount++;
+}
+
+int32 UInventorySystemComponent::BroadcastEquipmentSlotUseStateChanged(const FEquippedSlot& EquippedSlot)
+{
+	FInventoryTraceBroadcastScope BroadcastScope(this);
+	OnEquipmentSlotUseStateChanged.Broadcast(EquippedSlot, GetEquipmentSlotCharges(EquippedSlot), GetEquipmentSlotCooldownRemaining(EquippedSlot) > 0.f);
+	return 1;
+}
+
+UInventoryCooldownSubsystem* UInventorySystemComponent::GetCooldownSubsystem() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UInventoryCooldownSubsystem>() : nullptr;
+}
+
+AActor* UInventorySystemComponent::GetEquippedItemInstance(const FEquippedSlot& EquippedSlot) const
+{
+	const TWeakObjectPtr<AActor>* Instance = EquippedItemInstances.Find(EquippedSlot);
+	return Instance ? Instance->Get() : nullptr;
+}
+
+void UInventorySystemComponent::UpdateEquippedItemInstance(const FEquippedSlot& EquippedSlot, UItem* Item)
+{
+	// Slots equipped before play began are given their actors in BeginPlay
+	if(!bSpawnEquippedItemInstances || !HasBegunPlay())
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	UInventoryActorPoolSubsystem* ActorPool = World ? World->GetSubsystem<UInventoryActorPoolSubsystem>() : nullptr;
+	if(!ActorPool)
+	{
+		return;
+	}
+
+	/* Release before acquiring so swapping between items sharing an instance class hands the same actor straight back */
+	if(const TWeakObjectPtr<AActor>* Instance = EquippedItemInstances.Find(EquippedSlot))
+	{
+		ActorPool->ReleaseActor(Instance->Get());
+		EquippedItemInstances.Remove(EquippedSlot);
+	}
+
+	if(Item && Item->ItemInstanceClass)
+	{
+		AActor* AttachTo = AvatarActor ? AvatarActor : GetOwner();
+		if(AActor* Instance = ActorPool->AcquireActor(Item->ItemInstanceClass, AttachTo, Item))
+		{
+			EquippedItemInstances.Add(EquippedSlot, Instance);
+		}
+	}
+}
+
+void UInventorySystemComponent::PrewarmItemInstancePools()
+{
+	UWorld* World = GetWorld();
+	UInventoryActorPoolSubsystem* ActorPool = World ? World->GetSubsystem<UInventoryActorPoolSubsystem>() : nullptr;
+	if(!ActorPool)
+	{
+		return;
+	}
+
+	TMap<TSubclassOf<AActor>, int32> InstanceCounts;
+	for(const FDefaultInventoryData& InventorySlot : DefaultInventoryItemData)
+	{
+		UItem* Item = InventorySlot.Item;
+		FEquippedSlot EquippedSlot;
+		if(Item && Item->ItemInstanceClass && DefaultEquipmentSlots.Contains(Item->GetItemType()) && !IsItemEquipped(Item, EquippedSlot))
+		{
+			InstanceCounts.FindOrAdd(Item->ItemInstanceClass)++;
+		}
+	}
+
+	for(const TPair<TSubclassOf<AActor>, int32>& Pair : InstanceCounts)
+	{
+		ActorPool->PrewarmPool(Pair.Key, Pair.Value);
+	}
+}
+
+void UInventorySystemComponent::ReleaseEquippedItemInstances()
+{
+	UWorld* World = GetWorld();
+	UInventoryActorPoolSubsystem* ActorPool = World ? World->GetSubsystem<UInventoryActorPoolSubsystem>() : nullptr;
+
+	if(ActorPool)
+	{
+		for(const TWeakObjectPtr<AActor>& Instance : EquippedItemInstances.GetValues())
+		{
+			ActorPool->ReleaseActor(Instance.Get());
+		}
+	}
+
+	EquippedItemInstances.Empty();
+}
+
+int64 UInventorySystemComponent::GetInventoryVersion() const
+{
+	return InventoryVersion;
+}
+
+int64 UInventorySystemComponent::GetItemVersion(const UItem* Item) const
+{
+	const FInventorySlotData* Slot = Item ? InventoryCore.FindSlot(Item) : nullptr;
+	return Slot ? Slot->Version : 0;
+}
+
+int64 UInventorySystemComponent::GetEquipmentSlotVersion(const FEquippedSlot& EquippedSlot) const
+{
+	const int64* Version = EquipmentSlotVersions.Find(EquippedSlot);
+	return Version ? *Version : 0;
+}
+
+bool UInventorySystemComponent::AddItemIfVersion(UItem* Item, int StackCount, int64 ExpectedVersion, int64& OutVersion)
+{
+	OutVersion = GetItemVersion(Item);
+	if(OutVersion != ExpectedVersion)
+	{
+		INC_DWORD_STAT(STAT_InventoryVersionConflicts);
+		return false;
+	}
+
+	const bool bResult = AddItem(Item, StackCount);
+	OutVersion = GetItemVersion(Item);
+	return bResult;
+}
+
+bool UInventorySystemComponent::RemoveItemIfVersion(UItem* Item, int StackCount, int64 ExpectedVersion, int64& OutVersion)
+{
+	OutVersion = GetItemVersion(Item);
+	if(OutVersion != ExpectedVersion)
+	{
+		INC_DWORD_STAT(STAT_InventoryVersionConflicts);
+		return false;
+	}
+
+	const bool bResult = RemoveItem(Item, StackCount);
+	OutVersion = GetItemVersion(Item);
+	return bResult;
+}
+
+bool UInventorySystemComponent::SetItemStateDataIfVersion(UItem* Item, FItemStateData ItemStateData, int64 ExpectedVersion, int64& OutVersion)
+{
+	OutVersion = GetItemVersion(Item);
+	if(OutVersion != ExpectedVersion)
+	{
+		INC_DWORD_STAT(STAT_InventoryVersionConflicts);
+		return false;
+	}
+
+	const bool bResult = SetItemStateData(Item, ItemStateData);
+	OutVersion = GetItemVersion(Item);
+	return bResult;
+}
+
+bool UInventorySystemComponent::AddItemToEquipmentSlotIfVersion(const FEquippedSlot& EquippedSlot, UItem* Item, int64 ExpectedVersion, int64& OutVersion)
+{
+	OutVersion = GetEquipmentSlotVersion(EquippedSlot);
+	if(OutVersion != ExpectedVersion)
+	{
+		INC_DWORD_STAT(STAT_InventoryVersionConflicts);
+		return false;
+	}
+
+	AddItemToEquipmentSlot(EquippedSlot, Item);
+	OutVersion = GetEquipmentSlotVersion(EquippedSlot);
+	return true;
+}
+
+bool UInventorySystemComponent::RemoveItemFromEquipmentSlotIfVersion(const FEquippedSlot& EquippedSlot, int64 ExpectedVersion, int64& OutVersion)
+{
+	OutVersion = GetEquipmentSlotVersion(EquippedSlot);
+	if(OutVersion != ExpectedVersion || !InventoryCore.HasEquipmentSlot(EquippedSlot))
+	{
+		INC_DWORD_STAT(STAT_InventoryVersionConflicts);
+		return false;
+	}
+
+	RemoveItemFromEquipmentSlot(EquippedSlot);
+	OutVersion = GetEquipmentSlotVersion(EquippedSlot);
+	return true;
+}
+
+int64 UInventorySystemComponent::AddInventoryViewer(UObject* Viewer)
+{
+	if(Viewer)
+	{
+		InventoryViewers.AddUnique(Viewer);
+		UpdateComponentTickEnabled();
+	}
+
+	return InventoryVersion;
+}
+
+void UInventorySystemComponent::RemoveInventoryViewer(UObject* Viewer)
+{
+	InventoryViewers.RemoveSingleSwap(Viewer);
+	UpdateComponentTickEnabled();
+}
+
+int32 UInventorySystemComponent::GetInventoryViewerCount() const
+{
+	return InventoryViewers.Num();
+}
+
+bool UInventorySystemComponent::GetChangesSince(int64 SinceVersion, TArray<FInventoryChangeRecord>& OutChanges)
+{
+	OutChanges.Reset();
+
+	if(SinceVersion == InventoryVersion)
+	{
+		return true;
+	}
+
+	// Writes older than the start of the journal or already overwritten by newer ones are gone
+	const int64 OldestVersion = FMath::Max(ChangeJournalStartVersion, InventoryVersion - ChangeJournal.Num() + 1);
+	if(ChangeJournalStartVersion == 0 || SinceVersion > InventoryVersion || SinceVersion + 1 < OldestVersion)
+	{
+		return false;
+	}
+
+	if(CachedChangesSinceVersion != SinceVersion || CachedChangesToVersion != InventoryVersion)
+	{
+		CachedChanges.Reset();
+
+		/* Walk the journal newest first so the first record we see for a slot is its latest, then flip back to oldest first */
+		TSet<const UItem*> SeenItems;
+		TSet<FEquippedSlot> SeenEquipmentSlots;
+
+		for(int64 Version = InventoryVersion; Version > SinceVersion; Version--)
+		{
+			const FInventoryChangeRecord& Record = ChangeJournal[(Version - 1) % ChangeJournal.Num()];
+			bool bAlreadySeen = false;
+
+			if(Record.IsEquipmentSlotChange())
+			{
+				SeenEquipmentSlots.Add(Record.EquippedSlot, &bAlreadySeen);
+			}
+			else
+			{
+				SeenItems.Add(Record.Item, &bAlreadySeen);
+			}
+
+			if(!bAlreadySeen)
+			{
+				CachedChanges.Add(Record);
+			}
+		}
+
+		Algo::Reverse(CachedChanges);
+		CachedChangesSinceVersion = SinceVersion;
+		CachedChangesToVersion = InventoryVersion;
+	}
+
+	OutChanges = CachedChanges;
+	return true;
+}
+
+FOnInventoryChangesAvailable& UInventorySystemComponent::GetInventoryChangesAvailableDelegate()
+{
+	return OnInventoryChangesAvailable;
+}
+
+int64 UInventorySystemComponent::RecordChange(UItem* Item, int32 StackCount, const FEquippedSlot& EquippedSlot)
+{
+	const int64 Version = ++InventoryVersion;
+
+	if(InventoryViewers.IsEmpty() || ChangeJournalCapacity <= 0)
+	{
+		return Version;
+	}
+
+	if(ChangeJournalStartVersion == 0)
+	{
+		ChangeJournal.SetNum(ChangeJournalCapacity);
+		ChangeJournalStartVersion = Version;
+	}
+
+	FInventoryChangeRecord& Record = ChangeJournal[(Version - 1) % ChangeJournal.Num()];
+	Record.Version = Version;
+	Record.Item = Item;
+	Record.StackCount = StackCount;
+	Record.EquippedSlot = EquippedSlot;
+	return Version;
+}
+
+void UInventorySystemComponent::BroadcastChangesAvailable()
+{
+	if(BroadcastInventoryVersion == InventoryVersion)
+	{
+		return;
+	}
+
+	BroadcastInventoryVersion = InventoryVersion;
+
+	if(InventoryViewers.ContainsByPredicate([](const TWeakObjectPtr<UObject>& Viewer) { return !Viewer.IsValid(); }))
+	{
+		UpdateComponentTickEnabled();
+	}
+
+	if(!InventoryViewers.IsEmpty())
+	{
+		FInventoryTraceBroadcastScope BroadcastScope(this);
+		OnInventoryChangesAvailable.Broadcast(InventoryVersion);
+	}
+}
+
+void UInventorySystemComponent::UpdateComponentTickEnabled()
+{
+	// Viewers that were destroyed without removing themselves no longer need the journal
+	InventoryViewers.RemoveAllSwap([](const TWeakObjectPtr<UObject>& Viewer) { return !Viewer.IsValid(); });
+
+	if(InventoryViewers.IsEmpty() && ChangeJournalStartVersion != 0)
+	{
+		ChangeJournal.Empty();
+		CachedChanges.Empty();
+		ChangeJournalStartVersion = 0;
+		CachedChangesSinceVersion = INDEX_NONE;
+		CachedChangesToVersion = INDEX_NONE;
+	}
+
+	if(HasBegunPlay())
+	{
+		SetComponentTickEnabled(EventDispatchMode == EInventoryEventDispatchMode::Deferred || !InventoryViewers.IsEmpty());
+	}
+}
+
+bool UInventorySystemComponent::EnqueueAddItem(UItem* Item, int32 StackCount)
+{
+	FInventoryCommand Command;
+	Command.Component = this;
+	Command.Item = Item;
+	Command.StackCount = StackCount;
+	Command.Type = EInventoryCommandType::AddItem;
+	return EnqueueCommand(MoveTemp(Command));
+}
+
+bool UInventorySystemComponent::EnqueueRemoveItem(UItem* Item, int32 StackCount)
+{
+	FInventoryCommand Command;
+	Command.Component = this;
+	Command.Item = Item;
+	Command.StackCount = StackCount;
+	Command.Type = EInventoryCommandType::RemoveItem;
+	return EnqueueCommand(MoveTemp(Command));
+}
+
+bool UInventorySystemComponent::EnqueueTryEquipItem(UItem* Item, const FEquippedSlot& OptionalSlot)
+{
+	FInventoryCommand Command;
+	Command.Component = this;
+	Command.Item = Item;
+	Command.EquippedSlot = OptionalSlot;
+	Command.Type = EInventoryCommandType::TryEquipItem;
+	return EnqueueCommand(MoveTemp(Command));
+}
+
+bool UInventorySystemComponent::EnqueueSetItemStateData(UItem* Item, const FItemStateData& ItemStateData)
+{
+	FInventoryCommand Command;
+	Command.Component = this;
+	Command.Item = Item;
+	Command.StateData = ItemStateData;
+	Command.Type = EInventoryCommandType::SetItemStateData;
+	return EnqueueCommand(MoveTemp(Command));
+}
+
+bool UInventorySystemComponent::EnqueueCommand(FInventoryCommand&& Command)
+{
+	TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> Channel;
+	{
+		FReadScopeLock ReadLock(CommandChannelLock);
+		Channel = CommandChannel;
+	}
+
+	return Channel && Channel->Enqueue(MoveTemp(Command));
+}
+
+void UInventorySystemComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> Channel;
+	const UWorld* World = GetWorld();
+	if(const UInventoryCommandSubsystem* CommandSubsystem = World ? World->GetSubsystem<UInventoryCommandSubsystem>() : nullptr)
+	{
+		Channel = CommandSubsystem->GetCommandChannel();
+	}
+
+	FWriteScopeLock WriteLock(CommandChannelLock);
+	CommandChannel = MoveTemp(Channel);
+}
+
+void UInventorySystemComponent::OnUnregister()
+{
+	{
+		FWriteScopeLock WriteLock(CommandChannelLock);
+		CommandChannel.Reset();
+	}
+
+	Super::OnUnregister();
+}
+
+void UInventorySystemComponent::SetEventDispatchMode(EInventoryEventDispatchMode NewDispatchMode)
+{
+	if(EventDispatchMode == NewDispatchMode)
+	{
+		return;
+	}
+
+	// Anything collected while deferred is still owed to our listeners
+	if(EventDispatchMode == EInventoryEventDispatchMode::Deferred)
+	{
+		FlushDeferredEvents();
+	}
+
+	EventDispatchMode = NewDispatchMode;
+	UpdateComponentTickEnabled();
+}
+
+EInventoryEventDispatchMode UInventorySystemComponent::GetEventDispatchMode() const
+{
+	return EventDispatchMode;
+}
+
+int32 UInventorySystemComponent::GetBroadcastsSavedLastFlush() const
+{
+	return BroadcastsSavedLastFlush;
+}
+
+void UInventorySystemComponent::FlushDeferredEvents()
+{
+	if(PendingItemChanges.IsEmpty() && PendingEquipmentChanges.IsEmpty() && PendingEquipmentUseStateChanges.IsEmpty() && PendingEquipmentLoadouts.IsEmpty())
+	{
+		BroadcastsSavedLastFlush = 0;
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_InventoryFlushDeferredEvents);
+
+	// Reads made while flushing are ours, not our callers, keep them out of any trace being recorded. What our listeners
+	// do in response is still recorded, the broadcasts open their own scopes
+	FInventoryTraceScope TraceScope(this, EInventoryTraceOp::None);
+
+	/* Take the pending changes before broadcasting, anything our listeners change while we flush is collected for the next flush */
+	FItemChangeStorage ItemChanges = MoveTemp(PendingItemChanges);
+	FEquipmentChangeStorage EquipmentChanges = MoveTemp(PendingEquipmentChanges);
+	TArray<FEquippedSlot> UseStateChanges = MoveTemp(PendingEquipmentUseStateChanges);
+	TArray<FPendingEquipmentLoadout> LoadoutChanges = MoveTemp(PendingEquipmentLoadouts);
+	const int32 ImmediateBroadcastCount = PendingBroadcastCount;
+	PendingItemChanges.Empty();
+	PendingEquipmentChanges.Empty();
+	PendingEquipmentUseStateChanges.Empty();
+	PendingEquipmentLoadouts.Empty();
+	PendingBroadcastCount = 0;
+
+	int32 BroadcastCount = 0;
+
+	for(int32 Index = 0; Index < ItemChanges.Num(); Index++)
+	{
+		UItem* Item = ItemChanges.GetKeyAt(Index);
+		const int32 OldStackCount = ItemChanges.GetValueAt(Index);
+		const int32 NewStackCount = GetItemStackCount(Item);
+
+		if(OldStackCount != NewStackCount)
+		{
+			BroadcastCount += BroadcastItemChanged(Item, OldStackCount, NewStackCount);
+		}
+	}
+
+	for(int32 Index = 0; Index < EquipmentChanges.Num(); Index++)
+	{
+		const FEquippedSlot& EquippedSlot = EquipmentChanges.GetKeyAt(Index);
+		UItem* OldItem = EquipmentChanges.GetValueAt(Index);
+		UItem* NewItem = GetItemAtEquipmentSlot(EquippedSlot);
+
+		if(OldItem != NewItem)
+		{
+			BroadcastCount += BroadcastEquipmentSlotChanged(EquippedSlot, OldItem, NewItem);
+		}
+	}
+
+	for(const FEquippedSlot& EquippedSlot : UseStateChanges)
+	{
+		BroadcastCount += BroadcastEquipmentSlotUseStateChanged(EquippedSlot);
+	}
+
+	for(const FPendingEquipmentLoadout& LoadoutChange : LoadoutChanges)
+	{
+		FInventoryTraceBroadcastScope BroadcastScope(this);
+		OnEquipmentLoadoutApplied.Broadcast(LoadoutChange.LoadoutName, LoadoutChange.ChangedSlots);
+		BroadcastCount++;
+	}
+
+	BroadcastsSavedLastFlush = FMath::Max(0, ImmediateBroadcastCount - BroadcastCount);
+	INC_DWORD_STAT_BY(STAT_InventoryBroadcastsSaved, BroadcastsSavedLastFlush);
+}
+
+void UInventorySystemComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetTickGroup(EventFlushTickGroup);
+	UpdateComponentTickEnabled();
+
+	if(bSpawnEquippedItemInstances)
+	{
+		// Reads made while spawning are ours, not our callers
+		FInventoryTraceScope TraceScope(this, EInventoryTraceOp::None);
+
+		const FEquipmentStorage& EquipmentStorage = InventoryCore.GetEquipmentStorage();
+		for(int32 Index = 0; Index < EquipmentStorage.Num(); Index++)
+		{
+			if(UItem* Item = EquipmentStorage.GetValueAt(Index))
+			{
+				UpdateEquippedItemInstance(EquipmentStorage.GetKeyAt(Index), Item);
+			}
+		}
+
+		PrewarmItemInstancePools();
+	}
+}
+
+void UInventorySystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FlushDeferredEvents();
+
+	// Our timers would expire into a weak pointer anyway, cancelling them keeps the shared wheel small
+	ClearEquipmentSlotUseStates();
+
+	ReleaseEquippedItemInstances();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInventorySystemComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	FlushDeferredEvents();
+	BroadcastChangesAvailable();
+}
+
+void UInventorySystemComponent::NotifyItemChanged(UItem* Item, int32 OldStackCount, int32 NewStackCount)
+{
+	if(EventDispatchMode == EInventoryEventDispatchMode::Immediate)
+	{
+		BroadcastItemChanged(Item, OldStackCount, NewStackCount);
+		return;
+	}
+
+	// Only remember the stack count the item had before its first change this frame, the flush diffs against the current count
+	if(!PendingItemChanges.Contains(Item))
+	{
+		PendingItemChanges.Add(Item, OldStackCount);
+	}
+
+	PendingBroadcastCount += NewStackCount > 0 && ItemStackCountChangedMap.Contains(Item) ? 2 : 1;
+}
+
+void UInventorySystemComponent::NotifyEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem, EEquipmentSlotChangeType ChangeType)
+{
+	if(EventDispatchMode == EInventoryEventDispatchMode::Immediate)
+	{
+		// One event per call with the item it names, even when the slot already held it or was already empty
+		FInventoryTraceBroadcastScope BroadcastScope(this);
+		OnEquipmentSlotChanged.Broadcast(EquippedSlot, ChangeType == EEquipmentSlotChangeType::Added ? NewItem : OldItem, ChangeType);
+		return;
+	}
+
+	if(!PendingEquipmentChanges.Contains(EquippedSlot))
+	{
+		PendingEquipmentChanges.Add(EquippedSlot, OldItem);
+	}
+
+	PendingBroadcastCount++;
+}
+
+void UInventorySystemComponent::NotifyEquipmentLoadoutApplied(FName LoadoutName, const TArray<FEquippedSlot>& ChangedSlots)
+{
+	if(EventDispatchMode == EInventoryEventDispatchMode::Immediate)
+	{
+		FInventoryTraceBroadcastScope BroadcastScope(this);
+		OnEquipmentLoadoutApplied.Broadcast(LoadoutName, ChangedSlots);
+		return;
+	}
+
+	PendingBroadcastCount++;
+
+	// Applying the same loadout again before the flush only adds the slots it changed this time
+	if(FPendingEquipmentLoadout* PendingLoadout = PendingEquipmentLoadouts.FindByPredicate([LoadoutName](const FPendingEquipmentLoadout& Pending) { return Pending.LoadoutName == LoadoutName; }))
+	{
+		for(const FEquippedSlot& EquippedSlot : ChangedSlots)
+		{
+			PendingLoadout->ChangedSlots.AddUnique(EquippedSlot);
+		}
+
+		return;
+	}
+
+	PendingEquipmentLoadouts.Add({ LoadoutName, ChangedSlots });
+}
+
+int32 UInventorySystemComponent::BroadcastItemChanged(UItem* Item, int32 OldStackCount, int32 NewStackCount)
+{
+	FInventoryTraceBroadcastScope BroadcastScope(this);
+
+	/* Removed items are only announced through OnItemChanged, stack count listeners are not told about them */
+	if(NewStackCount <= 0)
+	{
+		OnItemChanged.Broadcast(Item, EInventorySlotChangeType::Removed);
+		return 1;
+	}
+
+	/* If we have a delegate listening for this items stack count to change, broadcast to it the old and new stack values.
+	 * It hears about growing stacks before OnItemChanged and about shrinking stacks after it */
+	FOnItemStackCountChanged* StackCountChanged = ItemStackCountChangedMap.Find(Item);
+	const bool bStackGrew = NewStackCount > OldStackCount;
+
+	if(StackCountChanged && bStackGrew)
+	{
+		StackCountChanged->Broadcast(OldStackCount, NewStackCount);
+	}
+
+	OnItemChanged.Broadcast(Item, OldStackCount <= 0 ? EInventorySlotChangeType::Added : EInventorySlotChangeType::StackChange);
+
+	if(StackCountChanged && !bStackGrew)
+	{
+		StackCountChanged->Broadcast(OldStackCount, NewStackCount);
+	}
+
+	return StackCountChanged ? 2 : 1;
+}
+
+int32 UInventorySystemComponent::BroadcastEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem)
+{
+	FInventoryTraceBroadcastScope BroadcastScope(this);
+	int32 BroadcastCount = 0;
+
+	if(OldItem && OldItem != NewItem)
+	{
+		OnEquipmentSlotChanged.Broadcast(EquippedSlot, OldItem, EEquipmentSlotChangeType::Removed);
+		BroadcastCount++;
+	}
+
+	if(NewItem)
+	{
+		OnEquipmentSlotChanged.Broadcast(EquippedSlot, NewItem, EEquipmentSlotChangeType::Added);
+		BroadcastCount++;
+	}
+
+	return BroadcastCount;
+}
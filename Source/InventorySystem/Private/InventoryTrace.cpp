@@ -0,0 +1,495 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryTrace.h"
+
+#include "InventorySystemComponent.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/ObjectKey.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogInventoryTrace, Log, All);
+
+std::atomic<bool> FInventoryTrace::bRecording(false);
+
+namespace InventoryTrace
+{
+	// Records the game thread can get ahead of the writer before records are dropped
+	static constexpr uint32 RingBufferCapacity = 1 << 16;
+
+	// How often the writer wakes up to drain the ring buffer
+	static constexpr uint32 FlushIntervalMs = 50;
+
+	struct FDefinition
+	{
+		uint32 Id;
+		EInventoryTraceDefinitionKind Kind;
+		FString Value;
+	};
+
+	/* An open trace file, owns the ring buffer and the background thread writing it out */
+	class FSession : public FRunnable
+	{
+	public:
+
+		FSession(FArchive* InWriter, const FString& InFilename)
+			: Records(RingBufferCapacity)
+			, Writer(InWriter)
+			, Filename(InFilename)
+			, Thread(nullptr)
+			, WakeEvent(FPlatformProcess::GetSynchEventFromPool())
+			, bStopping(false)
+			, DroppedRecords(0)
+			, WrittenRecords(0)
+			, NextId(1)
+		{
+		}
+
+		virtual ~FSession() override
+		{
+			FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+			delete Writer;
+		}
+
+		bool StartThread()
+		{
+			Thread = FRunnableThread::Create(this, TEXT("InventoryTraceWriter"), 0, TPri_BelowNormal);
+			return Thread != nullptr;
+		}
+
+		void StopThread()
+		{
+			bStopping = true;
+			WakeEvent->Trigger();
+
+			if(Thread)
+			{
+				Thread->WaitForCompletion();
+				delete Thread;
+				Thread = nullptr;
+			}
+		}
+
+		virtual uint32 Run() override
+		{
+			while(!bStopping)
+			{
+				WakeEvent->Wait(FlushIntervalMs);
+				Flush();
+			}
+
+			Flush();
+			return 0;
+		}
+
+		/* Game thread only */
+		void Record(const FInventoryTraceRecord& Record)
+		{
+			if(!Records.Enqueue(Record))
+			{
+				DroppedRecords++;
+			}
+		}
+
+		/* Game thread only */
+		uint32 GetObjectId(const UObject* Object)
+		{
+			if(!Object)
+			{
+				return 0;
+			}
+
+			if(const uint32* ExistingId = ObjectIds.Find(FObjectKey(Object)))
+			{
+				return *ExistingId;
+			}
+
+			const uint32 Id = NextId++;
+			ObjectIds.Add(FObjectKey(Object), Id);
+			AddDefinition(Id, EInventoryTraceDefinitionKind::Object, Object->GetPathName());
+			return Id;
+		}
+
+		/* Game thread only */
+		uint32 GetNameId(FName Name)
+		{
+			if(Name.IsNone())
+			{
+				return 0;
+			}
+
+			if(const uint32* ExistingId = NameIds.Find(Name))
+			{
+				return *ExistingId;
+			}
+
+			const uint32 Id = NextId++;
+			NameIds.Add(Name, Id);
+			AddDefinition(Id, EInventoryTraceDefinitionKind::Name, Name.ToString());
+			return Id;
+		}
+
+		uint64 GetDroppedRecordCount() const { return DroppedRecords; }
+
+		uint64 GetWrittenRecordCount() const { return WrittenRecords; }
+
+		const FString& GetFilename() const { return Filename; }
+
+	private:
+
+		void AddDefinition(uint32 Id, EInventoryTraceDefinitionKind Kind, FString&& Value)
+		{
+			FScopeLock Lock(&DefinitionsLock);
+			PendingDefinitions.Add({ Id, Kind, MoveTemp(Value) });
+		}
+
+		/* Writer thread only */
+		void Flush()
+		{
+			/* Drain records before taking the definitions, every definition a record uses was added before the record was
+			 * enqueued, so it is guaranteed to be written ahead of the records in this batch */
+			Batch.Reset();
+			FInventoryTraceRecord Record;
+			while(Records.Dequeue(Record))
+			{
+				Batch.Add(Record);
+			}
+
+			TArray<FDefinition> Definitions;
+			{
+				FScopeLock Lock(&DefinitionsLock);
+				Definitions = MoveTemp(PendingDefinitions);
+				PendingDefinitions.Reset();
+			}
+
+			if(!Definitions.IsEmpty())
+			{
+				uint8 ChunkType = InventoryTraceFormat::DefinitionsChunk;
+				uint32 Count = Definitions.Num();
+				*Writer << ChunkType << Count;
+
+				for(FDefinition& Definition : Definitions)
+				{
+					uint8 Kind = (uint8)Definition.Kind;
+					Writer->SerializeIntPacked(Definition.Id);
+					*Writer << Kind << Definition.Value;
+				}
+			}
+
+			if(!Batch.IsEmpty())
+			{
+				uint8 ChunkType = InventoryTraceFormat::RecordsChunk;
+				uint32 Count = Batch.Num();
+				*Writer << ChunkType << Count;
+
+				for(FInventoryTraceRecord& BatchRecord : Batch)
+				{
+					*Writer << BatchRecord;
+				}
+
+				WrittenRecords += Batch.Num();
+			}
+		}
+
+		TCircularQueue<FInventoryTraceRecord> Records;
+
+		FArchive* Writer;
+
+		FString Filename;
+
+		FRunnableThread* Thread;
+
+		FEvent* WakeEvent;
+
+		std::atomic<bool> bStopping;
+
+		std::atomic<uint64> DroppedRecords;
+
+		std::atomic<uint64> WrittenRecords;
+
+		// Definitions are created on the game thread and written by the writer thread
+		FCriticalSection DefinitionsLock;
+
+		TArray<FDefinition> PendingDefinitions;
+
+		// Writer thread scratch space, kept around to avoid reallocating every flush
+		TArray<FInventoryTraceRecord> Batch;
+
+		// Game thread state
+		TMap<FObjectKey, uint32> ObjectIds;
+
+		TMap<FName, uint32> NameIds;
+
+		uint32 NextId;
+	};
+
+	static FSession* ActiveSession = nullptr;
+
+	static void StartCommand(const TArray<FString>& Args)
+	{
+		FString Filename;
+		if(Args.Num() > 0)
+		{
+			Filename = Args[0];
+		}
+		else
+		{
+			Filename = FPaths::ProfilingDir() / TEXT("InventoryTraces") / FString::Printf(TEXT("Inventory-%s.invtrace"), *FDateTime::Now().ToString());
+		}
+
+		FInventoryTrace::StartRecording(Filename);
+	}
+
+	static FAutoConsoleCommand StartRecordingCommand(
+		TEXT("Inventory.Trace.Start"),
+		TEXT("Starts recording every inventory component API call to a trace file. Usage: Inventory.Trace.Start [Filename]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StartCommand));
+
+	static FAutoConsoleCommand StopRecordingCommand(
+		TEXT("Inventory.Trace.Stop"),
+		TEXT("Stops recording inventory component API calls and closes the trace file"),
+		FConsoleCommandDelegate::CreateStatic(&FInventoryTrace::StopRecording));
+}
+
+const TCHAR* LexToString(EInventoryTraceOp Op)
+{
+	switch(Op)
+	{
+	case EInventoryTraceOp::AddItem: return TEXT("AddItem");
+	case EInventoryTraceOp::AddItemAndEquip: return TEXT("AddItemAndEquip");
+	case EInventoryTraceOp::RemoveItem: return TEXT("RemoveItem");
+	case EInventoryTraceOp::SetItemStateData: return TEXT("SetItemStateData");
+	case EInventoryTraceOp::GetItemStateData: return TEXT("GetItemStateData");
+	case EInventoryTraceOp::GetInventoryItems: return TEXT("GetInventoryItems");
+	case EInventoryTraceOp::GetItemStackCount: return TEXT("GetItemStackCount");
+	case EInventoryTraceOp::HasItem: return TEXT("HasItem");
+	case EInventoryTraceOp::TryEquipItem: return TEXT("TryEquipItem");
+	case EInventoryTraceOp::UseItemAtEquipmentSlot: return TEXT("UseItemAtEquipmentSlot");
+	case EInventoryTraceOp::GetTotalEquipmentSlotsOfType: return TEXT("GetTotalEquipmentSlotsOfType");
+	case EInventoryTraceOp::IsItemEquipped: return TEXT("IsItemEquipped");
+	case EInventoryTraceOp::GetItemAtEquipmentSlot: return TEXT("GetItemAtEquipmentSlot");
+	case EInventoryTraceOp::GetFirstAvailableEquipmentSlot: return TEXT("GetFirstAvailableEquipmentSlot");
+	case EInventoryTraceOp::AddItemToEquipmentSlot: return TEXT("AddItemToEquipmentSlot");
+	case EInventoryTraceOp::RemoveItemFromEquipmentSlot: return TEXT("RemoveItemFromEquipmentSlot");
+	case EInventoryTraceOp::AddEquipmentSlot: return TEXT("AddEquipmentSlot");
+	case EInventoryTraceOp::SaveEquipmentLoadout: return TEXT("SaveEquipmentLoadout");
+	case EInventoryTraceOp::ApplyEquipmentLoadout: return TEXT("ApplyEquipmentLoadout");
+	case EInventoryTraceOp::RemoveEquipmentLoadout: return TEXT("RemoveEquipmentLoadout");
+	default: return TEXT("None");
+	}
+}
+
+bool FInventoryTraceRecord::UsesItem(EInventoryTraceOp Op)
+{
+	switch(Op)
+	{
+	case EInventoryTraceOp::AddItem:
+	case EInventoryTraceOp::AddItemAndEquip:
+	case EInventoryTraceOp::RemoveItem:
+	case EInventoryTraceOp::SetItemStateData:
+	case EInventoryTraceOp::GetItemStateData:
+	case EInventoryTraceOp::GetItemStackCount:
+	case EInventoryTraceOp::HasItem:
+	case EInventoryTraceOp::TryEquipItem:
+	case EInventoryTraceOp::IsItemEquipped:
+	case EInventoryTraceOp::AddItemToEquipmentSlot:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FInventoryTraceRecord::UsesIntArg(EInventoryTraceOp Op)
+{
+	return Op == EInventoryTraceOp::AddItem || Op == EInventoryTraceOp::AddItemAndEquip || Op == EInventoryTraceOp::RemoveItem;
+}
+
+bool FInventoryTraceRecord::UsesSlot(EInventoryTraceOp Op)
+{
+	switch(Op)
+	{
+	case EInventoryTraceOp::GetInventoryItems:
+	case EInventoryTraceOp::TryEquipItem:
+	case EInventoryTraceOp::UseItemAtEquipmentSlot:
+	case EInventoryTraceOp::GetTotalEquipmentSlotsOfType:
+	case EInventoryTraceOp::GetItemAtEquipmentSlot:
+	case EInventoryTraceOp::GetFirstAvailableEquipmentSlot:
+	case EInventoryTraceOp::AddItemToEquipmentSlot:
+	case EInventoryTraceOp::RemoveItemFromEquipmentSlot:
+	case EInventoryTraceOp::AddEquipmentSlot:
+	case EInventoryTraceOp::SaveEquipmentLoadout:
+	case EInventoryTraceOp::ApplyEquipmentLoadout:
+	case EInventoryTraceOp::RemoveEquipmentLoadout:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FInventoryTraceRecord::UsesStateData(EInventoryTraceOp Op)
+{
+	return Op == EInventoryTraceOp::SetItemStateData;
+}
+
+FArchive& operator<<(FArchive& Ar, FInventoryTraceRecord& Record)
+{
+	uint8 Op = (uint8)Record.Op;
+	Ar << Op;
+	Record.Op = (EInventoryTraceOp)Op;
+
+	Ar.SerializeIntPacked64(Record.Frame);
+	Ar.SerializeIntPacked(Record.ComponentId);
+
+	if(FInventoryTraceRecord::UsesItem(Record.Op))
+	{
+		Ar.SerializeIntPacked(Record.ItemId);
+	}
+
+	if(FInventoryTraceRecord::UsesIntArg(Record.Op))
+	{
+		Ar << Record.IntArg;
+	}
+
+	if(FInventoryTraceRecord::UsesSlot(Record.Op))
+	{
+		// Slot numbers are never below INDEX_NONE, shift them so they pack as small unsigned values
+		uint32 PackedSlotNumber = (uint32)(Record.SlotNumber + 1);
+		Ar.SerializeIntPacked(Record.NameId);
+		Ar.SerializeIntPacked(PackedSlotNumber);
+		Record.SlotNumber = (int32)PackedSlotNumber - 1;
+	}
+
+	if(FInventoryTraceRecord::UsesStateData(Record.Op))
+	{
+		Ar << Record.Magnitude << Record.Location;
+		Ar.SerializeIntPacked(Record.OptionalObjectId);
+	}
+
+	return Ar;
+}
+
+bool FInventoryTrace::StartRecording(const FString& Filename)
+{
+	check(IsInGameThread());
+
+	if(InventoryTrace::ActiveSession)
+	{
+		UE_LOG(LogInventoryTrace, Warning, TEXT("Already recording an inventory trace to %s"), *InventoryTrace::ActiveSession->GetFilename());
+		return false;
+	}
+
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*Filename);
+	if(!Writer)
+	{
+		UE_LOG(LogInventoryTrace, Error, TEXT("Could not open %s for writing an inventory trace"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = InventoryTraceFormat::Magic;
+	uint32 Version = InventoryTraceFormat::Version;
+	*Writer << Magic << Version;
+
+	InventoryTrace::FSession* Session = new InventoryTrace::FSession(Writer, Filename);
+	if(!Session->StartThread())
+	{
+		UE_LOG(LogInventoryTrace, Error, TEXT("Could not start the inventory trace writer thread"));
+		delete Session;
+		return false;
+	}
+
+	InventoryTrace::ActiveSession = Session;
+	bRecording.store(true);
+
+	UE_LOG(LogInventoryTrace, Log, TEXT("Recording inventory trace to %s"), *Filename);
+	return true;
+}
+
+void FInventoryTrace::StopRecording()
+{
+	check(IsInGameThread());
+
+	InventoryTrace::FSession* Session = InventoryTrace::ActiveSession;
+	if(!Session)
+	{
+		return;
+	}
+
+	bRecording.store(false);
+	InventoryTrace::ActiveSession = nullptr;
+
+	Session->StopThread();
+
+	UE_LOG(LogInventoryTrace, Log, TEXT("Stopped recording inventory trace to %s, %llu records written, %llu dropped"),
+		*Session->GetFilename(), Session->GetWrittenRecordCount(), Session->GetDroppedRecordCount());
+
+	delete Session;
+}
+
+uint64 FInventoryTrace::GetDroppedRecordCount()
+{
+	return InventoryTrace::ActiveSession ? InventoryTrace::ActiveSession->GetDroppedRecordCount() : 0;
+}
+
+void FInventoryTrace::RecordOperation(const UInventorySystemComponent* Component, EInventoryTraceOp Op, const UObject* Item, int32 IntArg, const FEquippedSlot& Slot, const FItemStateData* StateData)
+{
+	InventoryTrace::FSession* Session = InventoryTrace::ActiveSession;
+	if(!Session || !IsInGameThread())
+	{
+		return;
+	}
+
+	FInventoryTraceRecord Record;
+	Record.Op = Op;
+	Record.Frame = GFrameCounter;
+	Record.ComponentId = Session->GetObjectId(Component);
+	Record.ItemId = Session->GetObjectId(Item);
+	Record.IntArg = IntArg;
+	Record.NameId = Session->GetNameId(Slot.SlotType.GetName());
+	Record.SlotNumber = Slot.SlotNumber;
+
+	if(StateData)
+	{
+		Record.Magnitude = StateData->Magnitude;
+		Record.Location = FVector3f(StateData->LocationData);
+		Record.OptionalObjectId = Session->GetObjectId(StateData->OptionalObject);
+	}
+
+	Session->Record(Record);
+}
+
+FInventoryTraceScope::FInventoryTraceScope(const UInventorySystemComponent* InComponent, EInventoryTraceOp Op, const UObject* Item, int32 IntArg, const FEquippedSlot& Slot, const FItemStateData* StateData)
+	: Component(InComponent)
+{
+	if(Component->TraceScopeDepth++ == 0 && Op != EInventoryTraceOp::None && FInventoryTrace::IsRecording())
+	{
+		FInventoryTrace::RecordOperation(Component, Op, Item, IntArg, Slot, StateData);
+	}
+}
+
+FInventoryTraceScope::FInventoryTraceScope(const UInventorySystemComponent* Component, EInventoryTraceOp Op, FName Name)
+	: FInventoryTraceScope(Component, Op, nullptr, 0, FEquippedSlot(FPrimaryAssetType(Name), INDEX_NONE))
+{
+}
+
+FInventoryTraceScope::~FInventoryTraceScope()
+{
+	Component->TraceScopeDepth--;
+}
+
+FInventoryTraceBroadcastScope::FInventoryTraceBroadcastScope(const UInventorySystemComponent* InComponent)
+	: Component(InComponent)
+	, SavedScopeDepth(InComponent->TraceScopeDepth)
+{
+	Component->TraceScopeDepth = 0;
+}
+
+FInventoryTraceBroadcastScope::~FInventoryTraceBroadcastScope()
+{
+	Component->TraceScopeDepth = SavedScopeDepth;
+}
@@ -38,11 +38,63 @@ bool UItem::ConsumeOnUse() const
 	return bConsumeOnUse;
 }
 
+float UItem::GetUseCooldown() const
+{
+	return UseCooldown;
+}
+
+int32 UItem::GetMaxCharges() const
+{
+	return MaxCharges;
+}
+
+float UItem::GetChargeRecoveryTime() const
+{
+	return ChargeRecoveryTime;
+}
+
 FString UItem::GetIdentifierString() const
 {
 	return GetPrimaryAssetId().ToString();
 }
 
+void UItem::SetItemName(FName NewItemName)
+{
+	if(ItemName != NewItemName)
+	{
+		ItemName = NewItemName;
+		OnItemSortKeysChanged().Broadcast(this);
+	}
+}
+
+void UItem::SetItemType(FPrimaryAssetType NewItemType)
+{
+	if(ItemType != NewItemType)
+	{
+		ItemType = NewItemType;
+		OnItemSortKeysChanged().Broadcast(this);
+	}
+}
+
+FOnItemSortKeysChanged& UItem::OnItemSortKeysChanged()
+{
+	static FOnItemSortKeysChanged Delegate;
+	return Delegate;
+}
+
+#if WITH_EDITOR
+void UItem::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	const FName PropertyName = PropertyChangedEvent.GetMemberPropertyName();
+	if(PropertyName == GET_MEMBER_NAME_CHECKED(UItem, ItemName) || PropertyName == GET_MEMBER_NAME_CHECKED(UItem, ItemType))
+	{
+		OnItemSortKeysChanged().Broadcast(this);
+	}
+}
+#endif
+
 FPrimaryAssetId UItem::GetPrimaryAssetId() const
 {
 	return FPrimaryAssetId(ItemType, GetFName());
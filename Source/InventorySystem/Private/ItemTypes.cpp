@@ -1,4 +1,226 @@
 ﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 
-#include "ItemTypes.h"
\ No newline at end of file
+#include "ItemTypes.h"
+
+#include "Engine/NetSerialization.h"
+
+namespace ItemTypes
+{
+	/* Quantization changes the bit stream, these must match on every machine in a session so they can only be set from config or the command line */
+	static TAutoConsoleVariable<int32> CVarMagnitudeScale(
+		TEXT("Inventory.Net.MagnitudeScale"),
+		0,
+		TEXT("Item state magnitudes are sent as a whole number of 1 / Scale steps. 0 sends whole numbers compactly and anything else at full precision."),
+		ECVF_ReadOnly);
+
+	static TAutoConsoleVariable<int32> CVarLocationQuantization(
+		TEXT("Inventory.Net.LocationQuantization"),
+		0,
+		TEXT("Precision item state locations are sent at. 0: full precision, 1: whole units, 2: one decimal, 3: two decimals."),
+		ECVF_ReadOnly);
+
+	static TAutoConsoleVariable<FString> CVarSlotTypes(
+		TEXT("Inventory.Net.SlotTypes"),
+		TEXT(""),
+		TEXT("Comma separated equipment slot types sent as an index rather than by name, the list must be the same on every machine."),
+		ECVF_ReadOnly);
+
+	static const TArray<FPrimaryAssetType>& GetNetSlotTypes()
+	{
+		static const TArray<FPrimaryAssetType> SlotTypes = []()
+		{
+			TArray<FString> Names;
+			CVarSlotTypes.GetValueOnAnyThread().ParseIntoArray(Names, TEXT(","));
+
+			TArray<FPrimaryAssetType> Types;
+			for(const FString& Name : Names)
+			{
+				Types.AddUnique(FPrimaryAssetType(*Name.TrimStartAndEnd()));
+			}
+
+			return Types;
+		}();
+
+		return SlotTypes;
+	}
+
+	/* Small negative numbers stay small once packed */
+	static uint32 ZigZagEncode(int32 Value)
+	{
+		return (uint32)(Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	static int32 ZigZagDecode(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	static void SerializePackedInt(FArchive& Ar, int32& Value)
+	{
+		uint32 Packed = ZigZagEncode(Value);
+		Ar.SerializeIntPacked(Packed);
+		Value = ZigZagDecode(Packed);
+	}
+
+	static void SerializeFlag(FArchive& Ar, bool& bValue)
+	{
+		uint8 Bit = bValue ? 1 : 0;
+		Ar.SerializeBits(&Bit, 1);
+		bValue = Bit != 0;
+	}
+}
+
+bool FItemStateData::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	bool bHasMagnitude = Magnitude != 0.f;
+	bool bHasLocation = !LocationData.IsZero();
+	bool bHasObject = OptionalObject != nullptr;
+	ItemTypes::SerializeFlag(Ar, bHasMagnitude);
+	ItemTypes::SerializeFlag(Ar, bHasLocation);
+	ItemTypes::SerializeFlag(Ar, bHasObject);
+
+	if(bHasMagnitude)
+	{
+		const int32 MagnitudeScale = ItemTypes::CVarMagnitudeScale.GetValueOnAnyThread();
+		if(MagnitudeScale > 0)
+		{
+			// Magnitudes too large for the scale saturate instead of overflowing the step count
+			int32 Steps = FMath::RoundToInt32(FMath::Clamp((double)Magnitude * MagnitudeScale, (double)MIN_int32, (double)MAX_int32));
+			ItemTypes::SerializePackedInt(Ar, Steps);
+
+			// Only the receiving side sees the quantized value, the state being sent is left untouched
+			if(Ar.IsLoading())
+			{
+				Magnitude = (float)Steps / MagnitudeScale;
+			}
+		}
+		else
+		{
+			// Durability, ammo and the like are usually whole numbers, those fit in a byte or two
+			bool bIsWholeNumber = FMath::Abs(Magnitude) < (float)(1 << 24) && Magnitude == FMath::RoundToFloat(Magnitude);
+			ItemTypes::SerializeFlag(Ar, bIsWholeNumber);
+
+			if(bIsWholeNumber)
+			{
+				int32 WholeMagnitude = (int32)Magnitude;
+				ItemTypes::SerializePackedInt(Ar, WholeMagnitude);
+				Magnitude = (float)WholeMagnitude;
+			}
+			else
+			{
+				Ar << Magnitude;
+			}
+		}
+	}
+	else
+	{
+		Magnitude = 0.f;
+	}
+
+	if(bHasLocation)
+	{
+		switch(ItemTypes::CVarLocationQuantization.GetValueOnAnyThread())
+		{
+		case 1:
+			bOutSuccess &= SerializePackedVector<1, 24>(LocationData, Ar);
+			break;
+		case 2:
+			bOutSuccess &= SerializePackedVector<10, 27>(LocationData, Ar);
+			break;
+		case 3:
+			bOutSuccess &= SerializePackedVector<100, 30>(LocationData, Ar);
+			break;
+		default:
+			Ar << LocationData;
+			break;
+		}
+	}
+	else
+	{
+		LocationData = FVector::ZeroVector;
+	}
+
+	if(bHasObject)
+	{
+		Ar << OptionalObject;
+	}
+	else
+	{
+		OptionalObject = nullptr;
+	}
+
+	return true;
+}
+
+bool FEquippedSlot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	/* Index 0 is reserved for slot types that are not in the list and are sent by name */
+	const TArray<FPrimaryAssetType>& NetSlotTypes = ItemTypes::GetNetSlotTypes();
+	uint32 TypeIndex = Ar.IsSaving() ? (uint32)(NetSlotTypes.IndexOfByKey(SlotType) + 1) : 0;
+	Ar.SerializeInt(TypeIndex, NetSlotTypes.Num() + 1);
+
+	if(TypeIndex == 0)
+	{
+		FName TypeName = SlotType.GetName();
+		Ar << TypeName;
+		SlotType = FPrimaryAssetType(TypeName);
+	}
+	else if(NetSlotTypes.IsValidIndex(TypeIndex - 1))
+	{
+		SlotType = NetSlotTypes[TypeIndex - 1];
+	}
+	else
+	{
+		SlotType = FPrimaryAssetType();
+		bOutSuccess = false;
+	}
+
+	// Slot numbers start at -1 for an unset slot
+	uint32 PackedSlotNumber = (uint32)(FMath::Max(SlotNumber, -1) + 1);
+	Ar.SerializeIntPacked(PackedSlotNumber);
+	SlotNumber = (int32)PackedSlotNumber - 1;
+
+	return true;
+}
+
+bool FInventorySlotData::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	bool bHasItemData = !ItemData.IsDefault();
+	bool bHasVersion = Version != 0;
+	ItemTypes::SerializeFlag(Ar, bHasItemData);
+	ItemTypes::SerializeFlag(Ar, bHasVersion);
+
+	// Stack counts start at -1 for an unset slot and stay below INT16_MAX, so they pack into one to three bytes
+	uint32 PackedStackCount = (uint32)(FMath::Max(StackCount, -1) + 1);
+	Ar.SerializeIntPacked(PackedStackCount);
+	StackCount = (int32)PackedStackCount - 1;
+
+	if(bHasVersion)
+	{
+		uint64 PackedVersion = (uint64)FMath::Max<int64>(Version, 0);
+		Ar.SerializeIntPacked64(PackedVersion);
+		Version = (int64)PackedVersion;
+	}
+	else
+	{
+		Version = 0;
+	}
+
+	if(bHasItemData)
+	{
+		ItemData.NetSerialize(Ar, Map, bOutSuccess);
+	}
+	else
+	{
+		ItemData = FItemStateData();
+	}
+
+	return true;
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Item.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Shared helpers for the InventorySystem.Benchmarks automation tests.
+ *
+ * Benchmarks only fail on wrong results, timings are reported through AddInfo so they show up in the automation report
+ * and in -ExecCmds="Automation RunTests InventorySystem.Benchmarks" logs without making the test flaky on slow machines.
+ */
+namespace InventoryBenchmark
+{
+	constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext
+		| EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::PerfFilter;
+
+	/* Runs Body Iterations times and returns the average nanoseconds per call */
+	template<typename FunctorType>
+	double MeasureNanoseconds(int32 Iterations, FunctorType&& Body)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			Body(Iteration);
+		}
+
+		const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		return Iterations > 0 ? Seconds * 1e9 / Iterations : 0.0;
+	}
+
+	/* Creates Count items of the "Benchmark" type in the transient package, a negative MaxStackCount leaves stacks unlimited */
+	inline TArray<UItem*> CreateItems(int32 Count, int32 MaxStackCount = -1)
+	{
+		TArray<UItem*> Items;
+		Items.Reserve(Count);
+
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			UItem* Item = NewObject<UItem>(GetTransientPackage());
+			Item->ItemType = FPrimaryAssetType(TEXT("Benchmark"));
+			Item->MaxStackCount = MaxStackCount;
+			Items.Add(Item);
+		}
+
+		return Items;
+	}
+
+	/* Keeps a benchmark result alive so the optimizer cannot drop the loop that produced it */
+	template<typename ValueType>
+	void DoNotOptimize(const ValueType& Value)
+	{
+		volatile const ValueType Sink = Value;
+		(void)Sink;
+	}
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBenchmark.h"
+#include "InventoryCore.h"
+#include "InventorySystemComponent.h"
+#include "Item.h"
+#include "UObject/GCObject.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryCoreBenchmark
+{
+	constexpr int32 NumItems = 16;
+	constexpr int32 NumOperations = 200000;
+
+	/* What gameplay code owning a core directly would use, same items and stack rules as the component without events */
+	struct FNativePolicy : FInventoryCorePolicyBase
+	{
+		using ItemType = UItem;
+
+		static int32 GetMaxStackCount(const UItem* Item)
+		{
+			return Item->GetMaxStackCount();
+		}
+	};
+
+	using FNativeInventoryCore = TInventoryCore<FNativePolicy>;
+
+	/* A core owned outside of any UObject, it reports its items through FGCObject */
+	class FCoreOwner : public FGCObject
+	{
+	public:
+		FNativeInventoryCore Core;
+
+		virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+		{
+			Core.AddReferencedObjects(Collector);
+		}
+
+		virtual FString GetReferencerName() const override
+		{
+			return TEXT("InventoryCoreBenchmark::FCoreOwner");
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryCoreVsComponentBenchmark, "InventorySystem.Benchmarks.InventoryCore.CoreVsComponent", InventoryBenchmark::TestFlags)
+
+bool FInventoryCoreVsComponentBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace InventoryCoreBenchmark;
+
+	const TArray<UItem*> Items = InventoryBenchmark::CreateItems(NumItems);
+
+	FNativeInventoryCore Core;
+	UInventorySystemComponent* Component = NewObject<UInventorySystemComponent>(GetTransientPackage());
+	Component->SetEventDispatchMode(EInventoryEventDispatchMode::Immediate);
+
+	const double CoreAddNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		Core.AddItem(Items[Index % NumItems], 2);
+	});
+
+	const double ComponentAddNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		Component->AddItem(Items[Index % NumItems], 2);
+	});
+
+	int64 CoreSum = 0;
+	const double CoreGetNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		CoreSum += Core.GetStackCount(Items[(Index * 7) % NumItems]);
+	});
+
+	int64 ComponentSum = 0;
+	const double ComponentGetNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		ComponentSum += Component->GetItemStackCount(Items[(Index * 7) % NumItems]);
+	});
+
+	const double CoreRemoveNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		Core.RemoveItem(Items[Index % NumItems], 1);
+	});
+
+	const double ComponentRemoveNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumOperations, [&](int32 Index)
+	{
+		Component->RemoveItem(Items[Index % NumItems], 1);
+	});
+
+	InventoryBenchmark::DoNotOptimize(CoreSum + ComponentSum);
+	TestEqual(TEXT("Stack counts read from the core and the component agree"), CoreSum, ComponentSum);
+
+	int32 NumMismatchedItems = 0;
+	for(UItem* Item : Items)
+	{
+		NumMismatchedItems += Core.GetStackCount(Item) != Component->GetItemStackCount(Item) ? 1 : 0;
+	}
+
+	TestEqual(TEXT("The core and the component end up with the same stacks"), NumMismatchedItems, 0);
+	TestEqual(TEXT("Half of every stack is left"), Core.GetStackCount(Items[0]), NumOperations / NumItems);
+
+	AddInfo(FString::Printf(TEXT("%d operations over %d items, immediate dispatch without listeners:"), NumOperations, NumItems));
+	AddInfo(FString::Printf(TEXT("  add:     core %.1f ns, component %.1f ns"), CoreAddNanoseconds, ComponentAddNanoseconds));
+	AddInfo(FString::Printf(TEXT("  get:     core %.1f ns, component %.1f ns"), CoreGetNanoseconds, ComponentGetNanoseconds));
+	AddInfo(FString::Printf(TEXT("  remove:  core %.1f ns, component %.1f ns"), CoreRemoveNanoseconds, ComponentRemoveNanoseconds));
+
+	// A core held outside of a UObject keeps its items alive once its owner reports them
+	{
+		FCoreOwner Owner;
+		TArray<TWeakObjectPtr<UItem>> OwnedItems;
+		for(UItem* Item : InventoryBenchmark::CreateItems(NumItems))
+		{
+			Owner.Core.AddItem(Item, 1);
+			OwnedItems.Add(Item);
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+		int32 NumCollectedItems = 0;
+		for(const TWeakObjectPtr<UItem>& Item : OwnedItems)
+		{
+			NumCollectedItems += Item.IsValid() ? 0 : 1;
+		}
+
+		TestEqual(TEXT("Items reported by the core survive garbage collection"), NumCollectedItems, 0);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBenchmark.h"
+#include "InventoryInlineMap.h"
+#include "InventorySystemComponent.h"
+#include "Item.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryInlineMapBenchmark
+{
+	constexpr int32 NumLookups = 1000000;
+	constexpr int32 NumNPCs = 5000;
+	constexpr int32 ItemsPerNPC = 6;
+	constexpr int32 EquipmentSlotsPerNPC = 3;
+
+	/* Storage of a single NPC inventory in a given map layout, with what it costs on the heap */
+	template<typename InventoryMapType, typename EquipmentMapType, typename ListenerMapType>
+	struct TNPCStorage
+	{
+		InventoryMapType InventoryMap;
+		EquipmentMapType EquipmentMap;
+		ListenerMapType StackCountChangedMap;
+
+		void Fill(const TArray<UItem*>& Items)
+		{
+			for(int32 Slot = 0; Slot < EquipmentSlotsPerNPC; Slot++)
+			{
+				EquipmentMap.Add(FEquippedSlot(FPrimaryAssetType(TEXT("Benchmark")), Slot), nullptr);
+			}
+
+			for(UItem* Item : Items)
+			{
+				InventoryMap.Add(Item, FInventorySlotData(1));
+			}
+
+			StackCountChangedMap.Add(Items[0]);
+		}
+
+		SIZE_T GetAllocatedSize() const
+		{
+			return InventoryMap.GetAllocatedSize() + EquipmentMap.GetAllocatedSize() + StackCountChangedMap.GetAllocatedSize();
+		}
+
+		/* Containers that spilled to the heap, each holds at least one live allocation */
+		int32 GetNumHeapContainers() const
+		{
+			return (InventoryMap.GetAllocatedSize() > 0 ? 1 : 0) + (EquipmentMap.GetAllocatedSize() > 0 ? 1 : 0)
+				+ (StackCountChangedMap.GetAllocatedSize() > 0 ? 1 : 0);
+		}
+	};
+
+	using FInlineNPCStorage = TNPCStorage<UInventorySystemComponent::FInventoryStorage, UInventorySystemComponent::FEquipmentStorage, UInventorySystemComponent::FStackCountListenerStorage>;
+	using FTMapNPCStorage = TNPCStorage<TMap<UItem*, FInventorySlotData>, TMap<FEquippedSlot, UItem*>, TMap<const UItem*, FOnItemStackCountChanged>>;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryInlineMapLookupBenchmark, "InventorySystem.Benchmarks.InlineMap.Lookup", InventoryBenchmark::TestFlags)
+
+bool FInventoryInlineMapLookupBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace InventoryInlineMapBenchmark;
+
+	const TArray<UItem*> Items = InventoryBenchmark::CreateItems(256);
+
+	for(const int32 NumItems : { 2, 4, 8, 16, 64, 256 })
+	{
+		TInventoryInlineMap<UItem*, FInventorySlotData, UInventorySystemComponent::InlineItemCapacity> InlineMap;
+		TMap<UItem*, FInventorySlotData> HashMap;
+
+		for(int32 Index = 0; Index < NumItems; Index++)
+		{
+			InlineMap.Add(Items[Index], FInventorySlotData(Index + 1));
+			HashMap.Add(Items[Index], FInventorySlotData(Index + 1));
+		}
+
+		// Walk the keys with a stride co-prime to every size so lookups do not simply follow storage order
+		int64 InlineSum = 0;
+		const double InlineNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumLookups, [&](int32 Iteration)
+		{
+			InlineSum += InlineMap.FindChecked(Items[(Iteration * 7) % NumItems]).StackCount;
+		});
+
+		int64 HashSum = 0;
+		const double HashNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumLookups, [&](int32 Iteration)
+		{
+			HashSum += HashMap.FindChecked(Items[(Iteration * 7) % NumItems]).StackCount;
+		});
+
+		InventoryBenchmark::DoNotOptimize(InlineSum + HashSum);
+		TestEqual(FString::Printf(TEXT("Lookups over %d items agree"), NumItems), InlineSum, HashSum);
+
+		AddInfo(FString::Printf(TEXT("%3d items: inline map %.2f ns/lookup (%s), TMap %.2f ns/lookup"),
+			NumItems, InlineNanoseconds, InlineMap.IsUsingHashIndex() ? TEXT("hash index") : TEXT("linear scan"), HashNanoseconds));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryInlineMapAllocationBenchmark, "InventorySystem.Benchmarks.InlineMap.AllocationsPerNPC", InventoryBenchmark::TestFlags)
+
+bool FInventoryInlineMapAllocationBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace InventoryInlineMapBenchmark;
+
+	const TArray<UItem*> Items = InventoryBenchmark::CreateItems(ItemsPerNPC);
+
+	TArray<FInlineNPCStorage> InlineStorage;
+	TArray<FTMapNPCStorage> TMapStorage;
+	InlineStorage.SetNum(NumNPCs);
+	TMapStorage.SetNum(NumNPCs);
+
+	int64 InlineBytes = 0;
+	int32 InlineHeapContainers = 0;
+	int64 TMapBytes = 0;
+	int32 TMapHeapContainers = 0;
+
+	for(int32 NPC = 0; NPC < NumNPCs; NPC++)
+	{
+		InlineStorage[NPC].Fill(Items);
+		TMapStorage[NPC].Fill(Items);
+
+		InlineBytes += InlineStorage[NPC].GetAllocatedSize();
+		InlineHeapContainers += InlineStorage[NPC].GetNumHeapContainers();
+		TMapBytes += TMapStorage[NPC].GetAllocatedSize();
+		TMapHeapContainers += TMapStorage[NPC].GetNumHeapContainers();
+	}
+
+	// The whole component on top of its storage, versions, loadouts and delegates included
+	int64 ComponentBytes = 0;
+	TArray<UInventorySystemComponent*> Components;
+	Components.Reserve(NumNPCs);
+
+	for(int32 NPC = 0; NPC < NumNPCs; NPC++)
+	{
+		UInventorySystemComponent* Component = NewObject<UInventorySystemComponent>(GetTransientPackage());
+		for(int32 Slot = 0; Slot < EquipmentSlotsPerNPC; Slot++)
+		{
+			Component->AddEquipmentSlot(FEquippedSlot(FPrimaryAssetType(TEXT("Benchmark")), Slot));
+		}
+
+		for(UItem* Item : Items)
+		{
+			Component->AddItem(Item, 1);
+		}
+
+		Component->RegisterItemStackCountChangedEvent(Items[0]);
+		ComponentBytes += Component->GetMemoryStats().GetTotalBytes();
+		Components.Add(Component);
+	}
+
+	TestEqual(TEXT("Every NPC inventory holds its items"), Components.Last()->GetMemoryStats().NumItems, ItemsPerNPC);
+	TestEqual(TEXT("Inline storage stays off the heap"), InlineHeapContainers, 0);
+
+	AddInfo(FString::Printf(TEXT("%d NPCs with %d items, %d equipment slots and one stack count listener:"), NumNPCs, ItemsPerNPC, EquipmentSlotsPerNPC));
+	AddInfo(FString::Printf(TEXT("  inline storage: %.2f heap containers, %.1f heap bytes per NPC"),
+		(double)InlineHeapContainers / NumNPCs, (double)InlineBytes / NumNPCs));
+	AddInfo(FString::Printf(TEXT("  TMap storage:   %.2f heap containers, %.1f heap bytes per NPC"),
+		(double)TMapHeapContainers / NumNPCs, (double)TMapBytes / NumNPCs));
+	AddInfo(FString::Printf(TEXT("  component:      %.1f heap bytes per NPC as reported by GetMemoryStats"), (double)ComponentBytes / NumNPCs));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBenchmark.h"
+#include "InventoryItemRegistry.h"
+#include "InventorySystemComponent.h"
+#include "Item.h"
+#include "UObject/UObjectGlobals.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryItemRegistryBenchmark
+{
+	constexpr int32 NumComponents = 5000;
+	constexpr int32 ItemsPerComponent = 6;
+	constexpr int32 NumCollections = 3;
+
+	/* Average seconds a full purging garbage collection takes */
+	double MeasureGarbageCollection()
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for(int32 Collection = 0; Collection < NumCollections; Collection++)
+		{
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+		}
+
+		return FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / NumCollections;
+	}
+
+	/* Rooted components holding unrooted items of their own, created from a template so bPinItemsInRegistry is set before
+	 * PostInitProperties decides whether they pin */
+	TArray<UInventorySystemComponent*> CreateComponents(bool bPinItems)
+	{
+		UInventorySystemComponent* Template = NewObject<UInventorySystemComponent>(GetTransientPackage(), NAME_None, RF_ArchetypeObject | RF_Transient);
+		FBoolProperty* PinProperty = FindFProperty<FBoolProperty>(UInventorySystemComponent::StaticClass(), TEXT("bPinItemsInRegistry"));
+		check(PinProperty);
+		PinProperty->SetPropertyValue_InContainer(Template, bPinItems);
+
+		TArray<UInventorySystemComponent*> Components;
+		Components.Reserve(NumComponents);
+
+		for(int32 ComponentIndex = 0; ComponentIndex < NumComponents; ComponentIndex++)
+		{
+			UInventorySystemComponent* Component = NewObject<UInventorySystemComponent>(GetTransientPackage(), UInventorySystemComponent::StaticClass(), NAME_None, RF_Transient, Template);
+			Component->AddToRoot();
+
+			for(UItem* Item : InventoryBenchmark::CreateItems(ItemsPerComponent))
+			{
+				Component->AddItem(Item, 1);
+			}
+
+			Components.Add(Component);
+		}
+
+		return Components;
+	}
+
+	void DestroyComponents(TArray<UInventorySystemComponent*>& Components)
+	{
+		for(UInventorySystemComponent* Component : Components)
+		{
+			Component->RemoveFromRoot();
+		}
+
+		Components.Empty();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryItemRegistryGarbageCollectionBenchmark, "InventorySystem.Benchmarks.ItemRegistry.GarbageCollection", InventoryBenchmark::TestFlags)
+
+bool FInventoryItemRegistryGarbageCollectionBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace InventoryItemRegistryBenchmark;
+
+	if(!UInventoryItemRegistry::Get())
+	{
+		AddWarning(TEXT("No item registry in this process, only the reporting path can be measured"));
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	const double BaselineSeconds = MeasureGarbageCollection();
+
+	AddInfo(FString::Printf(TEXT("%d components with %d items each, full purge averaged over %d collections:"), NumComponents, ItemsPerComponent, NumCollections));
+	AddInfo(FString::Printf(TEXT("  no components:    %.2f ms"), BaselineSeconds * 1000.0));
+
+	for(const bool bPinItems : { false, true })
+	{
+		TArray<UInventorySystemComponent*> Components = CreateComponents(bPinItems);
+
+		TArray<UItem*> SampleItems;
+		Components.Last()->GetInventoryItems(FPrimaryAssetType(TEXT("Benchmark")), SampleItems);
+		const TWeakObjectPtr<UItem> SampleItem = SampleItems.IsEmpty() ? nullptr : SampleItems[0];
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+		const double Seconds = MeasureGarbageCollection();
+
+		TestTrue(FString::Printf(TEXT("Items survive garbage collection when %s"), bPinItems ? TEXT("pinned") : TEXT("reported")), SampleItem.IsValid());
+		TestEqual(FString::Printf(TEXT("Components keep their items when %s"), bPinItems ? TEXT("pinned") : TEXT("reported")),
+			Components.Last()->GetMemoryStats().NumItems, ItemsPerComponent);
+
+		AddInfo(FString::Printf(TEXT("  %s %.2f ms"), bPinItems ? TEXT("pinned items:    ") : TEXT("reported items:  "), Seconds * 1000.0));
+
+		DestroyComponents(Components);
+	}
+
+	return true;
+}
+
+#endif
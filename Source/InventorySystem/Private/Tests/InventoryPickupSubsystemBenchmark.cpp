@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBenchmark.h"
+#include "InventoryPickupSubsystem.h"
+#include "Item.h"
+#include "Engine/World.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryPickupSubsystemBenchmark
+{
+	constexpr int32 NumDrops = 50000;
+	constexpr int32 NumItems = 64;
+	constexpr int32 NumQueries = 1000;
+	constexpr int32 QueriesPerBatch = 64;
+	constexpr float WorldExtent = 50000.f;
+	constexpr float QueryRadius = 500.f;
+
+	FVector RandomLocation(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(0.f, 200.f));
+	}
+
+	/* What a query costs without the spatial hash, every drop is tested against the sphere */
+	int32 CountDropsInRadius(const TArray<FVector>& Locations, const FVector& Center, float Radius)
+	{
+		int32 Count = 0;
+		for(const FVector& Location : Locations)
+		{
+			Count += FVector::DistSquared(Location, Center) <= FMath::Square(Radius) ? 1 : 0;
+		}
+
+		return Count;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryPickupSubsystemBenchmark, "InventorySystem.Benchmarks.Pickups.FiftyThousandDrops", InventoryBenchmark::TestFlags)
+
+bool FInventoryPickupSubsystemBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace InventoryPickupSubsystemBenchmark;
+
+	// A game world of our own so the subsystem is created the way it is in game, nothing is rendered or ticked
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("InventoryPickupBenchmark"));
+	UInventoryPickupSubsystem* Pickups = World ? World->GetSubsystem<UInventoryPickupSubsystem>() : nullptr;
+	if(!TestNotNull(TEXT("Pickup subsystem"), Pickups))
+	{
+		if(World)
+		{
+			World->DestroyWorld(false);
+		}
+
+		return false;
+	}
+
+	const TArray<UItem*> Items = InventoryBenchmark::CreateItems(NumItems);
+
+	FRandomStream Random(1337);
+
+	TArray<FInventoryDropHandle> Handles;
+	TArray<FVector> Locations;
+	Handles.Reserve(NumDrops);
+	Locations.Reserve(NumDrops);
+
+	for(int32 Index = 0; Index < NumDrops; Index++)
+	{
+		Locations.Add(RandomLocation(Random));
+	}
+
+	const double DropNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumDrops, [&](int32 Index)
+	{
+		Handles.Add(Pickups->DropItem(Items[Index % NumItems], 1, FItemStateData(), Locations[Index]));
+	});
+
+	TestEqual(TEXT("Every drop is stored"), Pickups->GetNumDrops(), NumDrops);
+
+	TArray<FVector> QueryCenters;
+	for(int32 Index = 0; Index < NumQueries; Index++)
+	{
+		QueryCenters.Add(RandomLocation(Random));
+	}
+
+	// Queries against the spatial hash and the same queries against every drop must agree
+	int32 NumMismatchedQueries = 0;
+	TArray<FInventoryDropHandle> FoundDrops;
+	for(const FVector& Center : QueryCenters)
+	{
+		FoundDrops.Reset();
+		Pickups->QueryDropsInRadius(Center, QueryRadius, FoundDrops);
+		NumMismatchedQueries += FoundDrops.Num() != CountDropsInRadius(Locations, Center, QueryRadius) ? 1 : 0;
+	}
+
+	TestEqual(TEXT("Spatial hash queries match a linear scan"), NumMismatchedQueries, 0);
+
+	int64 NumFound = 0;
+	const double QueryNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumQueries, [&](int32 Index)
+	{
+		FoundDrops.Reset();
+		Pickups->QueryDropsInRadius(QueryCenters[Index], QueryRadius, FoundDrops);
+		NumFound += FoundDrops.Num();
+	});
+
+	int64 NumScanned = 0;
+	const double ScanNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumQueries, [&](int32 Index)
+	{
+		NumScanned += CountDropsInRadius(Locations, QueryCenters[Index], QueryRadius);
+	});
+
+	TArray<FInventoryDropQuery> Queries;
+	for(int32 Index = 0; Index < QueriesPerBatch; Index++)
+	{
+		FInventoryDropQuery& Query = Queries.AddDefaulted_GetRef();
+		Query.Center = QueryCenters[Index];
+		Query.Radius = QueryRadius;
+	}
+
+	TArray<int32> QueryStarts;
+	const double BatchNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumQueries / QueriesPerBatch, [&](int32 Iteration)
+	{
+		FoundDrops.Reset();
+		Pickups->QueryDropsInRadii(Queries, FoundDrops, QueryStarts);
+	});
+
+	const double MoveNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumDrops, [&](int32 Index)
+	{
+		Locations[Index] = RandomLocation(Random);
+		Pickups->MoveDrop(Handles[Index], Locations[Index]);
+	});
+
+	const SIZE_T AllocatedBytes = Pickups->GetAllocatedSize();
+
+	const double RemoveNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumDrops, [&](int32 Index)
+	{
+		Pickups->RemoveDrop(Handles[Index]);
+	});
+
+	InventoryBenchmark::DoNotOptimize(NumFound + NumScanned);
+	TestEqual(TEXT("Spatial hash and linear scan found the same drops"), NumFound, NumScanned);
+	TestEqual(TEXT("Every drop is removed"), Pickups->GetNumDrops(), 0);
+	TestFalse(TEXT("Removed handles are no longer valid"), Pickups->IsDropValid(Handles[0]));
+
+	AddInfo(FString::Printf(TEXT("%d drops of %d items over %.0f x %.0f units:"), NumDrops, NumItems, WorldExtent * 2.f, WorldExtent * 2.f));
+	AddInfo(FString::Printf(TEXT("  drop:    %.1f ns, %.1f bytes per drop"), DropNanoseconds, (double)AllocatedBytes / NumDrops));
+	AddInfo(FString::Printf(TEXT("  query:   %.1f ns per %.0f unit radius query (%.1f drops found), linear scan %.1f ns"),
+		QueryNanoseconds, QueryRadius, (double)NumFound / NumQueries, ScanNanoseconds));
+	AddInfo(FString::Printf(TEXT("  batch:   %.1f ns per query in batches of %d"), BatchNanoseconds / QueriesPerBatch, QueriesPerBatch));
+	AddInfo(FString::Printf(TEXT("  move:    %.1f ns"), MoveNanoseconds));
+	AddInfo(FString::Printf(TEXT("  remove:  %.1f ns"), RemoveNanoseconds));
+
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryBenchmark.h"
+#include "ItemTypes.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "UObject/CoreNet.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ItemTypesNetSerializeBenchmark
+{
+	constexpr int32 NumStates = 10000;
+
+	/* A mix of what replicated state data usually looks like, mostly empty or whole number durability and ammo */
+	TArray<FItemStateData> CreateStates()
+	{
+		FRandomStream Random(42);
+
+		TArray<FItemStateData> States;
+		States.SetNum(NumStates);
+
+		for(FItemStateData& State : States)
+		{
+			const float Roll = Random.GetFraction();
+			if(Roll < 0.4f)
+			{
+				continue;
+			}
+
+			if(Roll < 0.7f)
+			{
+				State.Magnitude = (float)Random.RandRange(0, 100);
+			}
+			else if(Roll < 0.85f)
+			{
+				State.Magnitude = Random.FRandRange(0.f, 1.f);
+			}
+			else
+			{
+				State.Magnitude = (float)Random.RandRange(1, 30);
+				State.LocationData = FVector(Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-1000.f, 1000.f));
+			}
+		}
+
+		return States;
+	}
+
+	/* Sets an Inventory.Net cvar for the lifetime of the scope, they are read only from the console but not from code */
+	struct FScopedNetCVar
+	{
+		IConsoleVariable* CVar;
+		int32 PreviousValue;
+
+		FScopedNetCVar(const TCHAR* Name, int32 Value)
+			: CVar(IConsoleManager::Get().FindConsoleVariable(Name))
+			, PreviousValue(CVar ? CVar->GetInt() : 0)
+		{
+			if(CVar)
+			{
+				CVar->Set(Value, ECVF_SetByCode);
+			}
+		}
+
+		~FScopedNetCVar()
+		{
+			if(CVar)
+			{
+				CVar->Set(PreviousValue, ECVF_SetByCode);
+			}
+		}
+	};
+
+	struct FQuantization
+	{
+		const TCHAR* Description;
+		int32 MagnitudeScale;
+		int32 LocationQuantization;
+		float MagnitudeTolerance;
+		float LocationTolerance;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemStateDataNetSerializeBenchmark, "InventorySystem.Benchmarks.NetSerialize.ItemStateData", InventoryBenchmark::TestFlags)
+
+bool FItemStateDataNetSerializeBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace ItemTypesNetSerializeBenchmark;
+
+	const TArray<FItemStateData> States = CreateStates();
+
+	// Every field written at full precision, what the struct costs without a net serializer
+	{
+		FNetBitWriter Writer(nullptr, NumStates * 512);
+		for(FItemStateData State : States)
+		{
+			Writer << State.Magnitude;
+			Writer << State.LocationData;
+		}
+
+		AddInfo(FString::Printf(TEXT("%d state data blocks, plain fields: %.1f bits per block"), NumStates, (double)Writer.GetNumBits() / NumStates));
+	}
+
+	const FQuantization Quantizations[] =
+	{
+		{ TEXT("lossless (default)"), 0, 0, 0.f, 0.f },
+		{ TEXT("magnitude 1/100"), 100, 0, 0.006f, 0.f },
+		{ TEXT("location one decimal"), 0, 2, 0.f, 0.06f },
+		{ TEXT("magnitude 1/100, location whole units"), 100, 1, 0.006f, 0.6f },
+	};
+
+	for(const FQuantization& Quantization : Quantizations)
+	{
+		FScopedNetCVar MagnitudeScale(TEXT("Inventory.Net.MagnitudeScale"), Quantization.MagnitudeScale);
+		FScopedNetCVar LocationQuantization(TEXT("Inventory.Net.LocationQuantization"), Quantization.LocationQuantization);
+
+		TArray<FItemStateData> SentStates = States;
+		FNetBitWriter Writer(nullptr, NumStates * 512);
+		bool bWriteSucceeded = true;
+
+		const double WriteNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumStates, [&](int32 Index)
+		{
+			bool bSuccess = true;
+			SentStates[Index].NetSerialize(Writer, nullptr, bSuccess);
+			bWriteSucceeded &= bSuccess;
+		});
+
+		FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+		TArray<FItemStateData> ReceivedStates;
+		ReceivedStates.SetNum(NumStates);
+		bool bReadSucceeded = true;
+
+		const double ReadNanoseconds = InventoryBenchmark::MeasureNanoseconds(NumStates, [&](int32 Index)
+		{
+			bool bSuccess = true;
+			ReceivedStates[Index].NetSerialize(Reader, nullptr, bSuccess);
+			bReadSucceeded &= bSuccess;
+		});
+
+		TestTrue(FString::Printf(TEXT("%s: every block serializes"), Quantization.Description), bWriteSucceeded && bReadSucceeded && !Reader.IsError());
+
+		int32 NumChangedBySending = 0;
+		int32 NumOutOfTolerance = 0;
+		for(int32 Index = 0; Index < NumStates; Index++)
+		{
+			NumChangedBySending += SentStates[Index].Magnitude != States[Index].Magnitude || SentStates[Index].LocationData != States[Index].LocationData ? 1 : 0;
+			NumOutOfTolerance += !FMath::IsNearlyEqual(ReceivedStates[Index].Magnitude, States[Index].Magnitude, Quantization.MagnitudeTolerance)
+				|| !ReceivedStates[Index].LocationData.Equals(States[Index].LocationData, Quantization.LocationTolerance) ? 1 : 0;
+		}
+
+		TestEqual(FString::Printf(TEXT("%s: sending leaves the state untouched"), Quantization.Description), NumChangedBySending, 0);
+		TestEqual(FString::Printf(TEXT("%s: received states are within tolerance"), Quantization.Description), NumOutOfTolerance, 0);
+
+		AddInfo(FString::Printf(TEXT("  %-40s %.1f bits per block, %.1f ns write, %.1f ns read"),
+			Quantization.Description, (double)Writer.GetNumBits() / NumStates, WriteNanoseconds, ReadNanoseconds));
+	}
+
+	// Magnitudes beyond what the scale can count saturate rather than wrapping around to the other sign
+	{
+		FScopedNetCVar MagnitudeScale(TEXT("Inventory.Net.MagnitudeScale"), 100);
+
+		FItemStateData LargeState;
+		LargeState.Magnitude = 1e12f;
+
+		FNetBitWriter Writer(nullptr, 256);
+		bool bSuccess = true;
+		LargeState.NetSerialize(Writer, nullptr, bSuccess);
+
+		FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+		FItemStateData ReceivedState;
+		ReceivedState.NetSerialize(Reader, nullptr, bSuccess);
+
+		TestTrue(TEXT("Large magnitudes saturate"), ReceivedState.Magnitude > 0.f);
+		TestEqual(TEXT("Large magnitudes are sent unchanged from the sender's view"), LargeState.Magnitude, 1e12f);
+	}
+
+	return true;
+}
+
+#endif
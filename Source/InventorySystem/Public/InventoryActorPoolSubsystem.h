@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryActorPoolSubsystem.generated.h"
+
+class UItem;
+
+/* Inactive actors of a single class waiting to be reused */
+USTRUCT()
+struct FInventoryActorPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<AActor*> InactiveActors;
+};
+
+/**
+ * Pools the item instance actors inventory components spawn for equipped items.
+ *
+ * Released actors are hidden, stop ticking and lose their collision rather than being destroyed, and the next item of
+ * the same instance class reuses them. Each class keeps at most Inventory.ActorPool.MaxPerClass inactive actors, any
+ * released past that are destroyed.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryActorPoolSubsystem();
+
+	/* Takes an inactive actor of the class from its pool or spawns one if the pool is empty, attached to AttachTo if given */
+	AActor* AcquireActor(TSubclassOf<AActor> ActorClass, AActor* AttachTo, UItem* Item);
+
+	/* Hides the actor and returns it to the pool of its class, destroys it if that pool is full */
+	void ReleaseActor(AActor* Actor);
+
+	/* Spawns inactive actors of the class until its pool holds at least Count, capped to the pool size */
+	void PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	int32 GetNumInactiveActors(TSubclassOf<AActor> ActorClass) const;
+
+	/* Actors spawned because their pool was empty, and actors handed out from a pool instead */
+	int32 GetNumSpawnedActors() const { return NumSpawnedActors; }
+	int32 GetNumReusedActors() const { return NumReusedActors; }
+
+	static int32 GetMaxPooledActorsPerClass();
+
+	virtual void Deinitialize() override;
+
+protected:
+
+	AActor* SpawnInactiveActor(TSubclassOf<AActor> ActorClass);
+
+	void DeactivateActor(AActor* Actor);
+
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<AActor>, FInventoryActorPool> Pools;
+
+	int32 NumSpawnedActors;
+
+	int32 NumReusedActors;
+};
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Bounded lock-free queue for many producer threads and a single consumer thread.
+ *
+ * Every cell carries a sequence number telling producers and the consumer whose turn it is to use it. A producer claims
+ * the next cell with a single compare and swap on the enqueue position, writes its element and publishes it by bumping
+ * the cell's sequence; the consumer reads cells in order until it reaches one that has not been published yet. Cells
+ * are allocated once up front, so neither side ever allocates, and a full queue rejects new elements instead of growing.
+ */
+template<typename ElementType>
+class TInventoryCommandQueue
+{
+public:
+
+	explicit TInventoryCommandQueue(uint32 InCapacity)
+		: Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		, Mask(Capacity - 1)
+		, Cells(new FCell[Capacity])
+		, EnqueuePosition(0)
+		, DequeuePosition(0)
+	{
+		for(uint32 Index = 0; Index < Capacity; Index++)
+		{
+			Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	TInventoryCommandQueue(const TInventoryCommandQueue&) = delete;
+	TInventoryCommandQueue& operator=(const TInventoryCommandQueue&) = delete;
+
+	/* Safe to call from any thread, returns false without blocking if the queue is full */
+	bool Enqueue(ElementType&& Element)
+	{
+		FCell* Cell;
+		uint64 Position = EnqueuePosition.load(std::memory_order_relaxed);
+
+		for(;;)
+		{
+			Cell = &Cells[Position & Mask];
+			const uint64 Sequence = Cell->Sequence.load(std::memory_order_acquire);
+			const int64 Difference = (int64)Sequence - (int64)Position;
+
+			if(Difference == 0)
+			{
+				if(EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(Difference < 0)
+			{
+				// The consumer has not freed this cell since the last lap, we are full
+				return false;
+			}
+			else
+			{
+				Position = EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		Cell->Element = MoveTemp(Element);
+		Cell->Sequence.store(Position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* Consumer thread only, returns false once every published element has been read */
+	bool Dequeue(ElementType& OutElement)
+	{
+		FCell& Cell = Cells[DequeuePosition & Mask];
+		const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+		if((int64)Sequence - (int64)(DequeuePosition + 1) < 0)
+		{
+			return false;
+		}
+
+		OutElement = MoveTemp(Cell.Element);
+		Cell.Sequence.store(DequeuePosition + Capacity, std::memory_order_release);
+		DequeuePosition++;
+		return true;
+	}
+
+	/* Consumer thread only, a producer may be about to publish more */
+	bool IsEmpty() const
+	{
+		const FCell& Cell = Cells[DequeuePosition & Mask];
+		return (int64)Cell.Sequence.load(std::memory_order_acquire) - (int64)(DequeuePosition + 1) < 0;
+	}
+
+	uint32 GetCapacity() const { return Capacity; }
+
+	SIZE_T GetAllocatedSize() const { return (SIZE_T)Capacity * sizeof(FCell); }
+
+private:
+
+	struct FCell
+	{
+		std::atomic<uint64> Sequence;
+		ElementType Element;
+	};
+
+	const uint32 Capacity;
+
+	const uint64 Mask;
+
+	TUniquePtr<FCell[]> Cells;
+
+	// Producers contend on this, keep it off the cache line the consumer writes
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePosition;
+
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint64 DequeuePosition;
+};
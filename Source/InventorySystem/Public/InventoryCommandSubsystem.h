@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryCommandQueue.h"
+#include "ItemTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryCommandSubsystem.generated.h"
+
+class UInventorySystemComponent;
+class UItem;
+
+enum class EInventoryCommandType : uint8
+{
+	AddItem,
+	RemoveItem,
+	TryEquipItem,
+	SetItemStateData
+};
+
+/* An inventory mutation queued from any thread, applied on the game thread through the component's regular API */
+struct FInventoryCommand
+{
+	TWeakObjectPtr<UInventorySystemComponent> Component;
+	UItem* Item = nullptr;
+	int32 StackCount = 0;
+	FEquippedSlot EquippedSlot;
+	FItemStateData StateData;
+	EInventoryCommandType Type = EInventoryCommandType::AddItem;
+};
+
+/**
+ * The queue behind a world's command subsystem. Shared with the components queueing into it, so a producer holding a
+ * reference can keep queueing safely while the world is torn down. Once the subsystem closes it, commands are rejected.
+ */
+class INVENTORYSYSTEM_API FInventoryCommandChannel
+{
+public:
+
+	explicit FInventoryCommandChannel(uint32 Capacity);
+
+	/* Safe to call from any thread, returns false if the channel is closed or the queue is full */
+	bool Enqueue(FInventoryCommand&& Command);
+
+	/* Game thread only */
+	bool Dequeue(FInventoryCommand& OutCommand);
+
+	/* Game thread only */
+	bool IsEmpty() const;
+
+	uint32 GetCapacity() const;
+
+	/* Rejects every later command, commands a producer was queueing at the same time may still land and are dropped
+	 * with the channel */
+	void Close();
+
+	uint64 GetNumRejectedCommands() const;
+
+private:
+
+	TInventoryCommandQueue<FInventoryCommand> Queue;
+
+	std::atomic<bool> bClosed;
+
+	std::atomic<uint64> NumRejectedCommands;
+};
+
+/**
+ * Applies inventory mutations queued from worker threads, such as quest rewards, crafting results or loot rolled on the
+ * task graph, without marshalling each one through its own game thread task.
+ *
+ * Commands for every component in the world go through one bounded lock-free queue sized by Inventory.CommandQueue.Capacity.
+ * Queueing never allocates, it only waits while a component is being registered or unregistered, and the queue is drained
+ * in a single batch once per frame after actors have ticked.
+ * Each command is applied through the same component function game thread code would call, so validation, versioning,
+ * tracing and events behave exactly as they would for a direct call.
+ *
+ * Items and optional objects passed in a command must be kept alive by the caller until the command has been applied.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryCommandSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/* Returns false if the queue is full or the world is being torn down. Worker threads should queue through a channel
+	 * reference from GetCommandChannel rather than through the subsystem, which may be destroyed under them */
+	bool EnqueueCommand(FInventoryCommand&& Command);
+
+	/* Game thread only, null before Initialize and after Deinitialize */
+	TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> GetCommandChannel() const;
+
+	/* Applies every queued command, called once per frame and before the world is torn down */
+	void DrainCommands();
+
+	/* Commands rejected because the queue was full or closed since the world was created */
+	uint64 GetNumRejectedCommands() const;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	void ApplyCommand(FInventoryCommand& Command);
+
+	TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> CommandChannel;
+};
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryTimerWheel.h"
+#include "ItemTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "InventoryCooldownSubsystem.generated.h"
+
+class UInventorySystemComponent;
+class UItem;
+
+enum class EInventoryCooldownTimerType : uint8
+{
+	// The slot can be used again
+	Cooldown,
+	// The slot recovers one charge
+	ChargeRecovery
+};
+
+/* What to notify when an equipment slot timer expires */
+struct FInventoryCooldownTimer
+{
+	TWeakObjectPtr<UInventorySystemComponent> Component;
+	FEquippedSlot EquippedSlot;
+	// Item that was used, it keeps recovering while out of the slot
+	TObjectKey<UItem> Item;
+	EInventoryCooldownTimerType Type = EInventoryCooldownTimerType::Cooldown;
+};
+
+/**
+ * Owns the timers behind equipment slot cooldowns and charge recovery for every inventory component in a world.
+ *
+ * Timers live in one shared hierarchical timer wheel, starting or cancelling one is O(1) and expiries are handed back
+ * to their components in a single batch per tick. With no timers running the tick does no work.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryCooldownSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Length of a timer wheel tick in seconds, timers are rounded up to a whole number of ticks
+	static constexpr double TimerResolution = 0.01;
+
+	UInventoryCooldownSubsystem();
+
+	FInventoryTimerHandle StartTimer(UInventorySystemComponent* Component, const FEquippedSlot& EquippedSlot, const UItem* Item, EInventoryCooldownTimerType Type, float Seconds);
+
+	void CancelTimer(FInventoryTimerHandle& Handle);
+
+	bool IsTimerActive(const FInventoryTimerHandle& Handle) const;
+
+	float GetRemainingTime(const FInventoryTimerHandle& Handle) const;
+
+	int32 GetActiveTimerCount() const;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	TInventoryTimerWheel<FInventoryCooldownTimer> TimerWheel;
+
+	// Time the wheel has been advanced through, kept in double so long sessions do not drift
+	double ElapsedTime;
+
+	// Reused every tick so expiring timers does not allocate
+	TArray<FInventoryCooldownTimer> ExpiredTimers;
+};
@@ -0,0 +1,327 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryInlineMap.h"
+#include "ItemTypes.h"
+
+/* Event sink that ignores every change, for native inventories nobody listens to */
+struct FInventoryCoreNullEventSink
+{
+	template<typename ItemType, typename SlotType>
+	void OnItemSlotChanged(ItemType* Item, const SlotType& OldSlot, SlotType* NewSlot) {}
+
+	template<typename EquipmentSlotType, typename ItemType>
+	void OnEquipmentSlotChanged(const EquipmentSlotType& EquippedSlot, ItemType* OldItem, ItemType* NewItem) {}
+};
+
+/**
+ * Defaults for TInventoryCore policies, a policy derives from this and overrides what it needs. On top of these a
+ * policy must provide:
+ *
+ *	using ItemType = ...;
+ *	static int32 GetMaxStackCount(const ItemType* Item);	// negative for no limit
+ *
+ * SlotType must be constructible from a stack count and expose a StackCount member, EventSinkType must provide the
+ * two functions of FInventoryCoreNullEventSink for the policy's item, slot and equipment slot types. Policies that
+ * change SlotType and report references through the core override AddSlotReferencedObjects.
+ */
+struct FInventoryCorePolicyBase
+{
+	using SlotType = FInventorySlotData;
+	using EquipmentSlotType = FEquippedSlot;
+	using EventSinkType = FInventoryCoreNullEventSink;
+
+	// Items / equipment slots stored inline before storage falls back to the heap and a hash index
+	static constexpr int32 InlineItemCapacity = 8;
+	static constexpr int32 InlineEquipmentCapacity = 4;
+
+	// Most distinct items the inventory holds, 0 for no limit
+	static constexpr int32 MaxItems = 0;
+
+	// Stack limit applied to items without one of their own
+	static constexpr int32 UnlimitedStackCount = INT16_MAX;
+
+	/* Reports the objects a slot references besides its item */
+	static void AddSlotReferencedObjects(FInventorySlotData& Slot, FReferenceCollector& Collector, const UObject* ReferencingObject)
+	{
+		Collector.AddReferencedObject(Slot.ItemData.OptionalObject, ReferencingObject);
+	}
+};
+
+/**
+ * Inventory storage and stack rules with everything that varies fixed at compile time by a policy type.
+ *
+ * Storage is sized by the policy's constexpr capacities, stack limits are read through a static policy function and
+ * changes are reported to an event sink held by value, so the hot path has no virtual calls, reflection or dynamic
+ * delegates. Performance critical gameplay code, such as the ammo spent in a weapon's fire path, can own one of these
+ * directly.
+ *
+ * UInventorySystemComponent keeps its items and equipment slots in one instantiation and leaves storage, stack rules and
+ * equipment queries to it. On top it adds what needs the engine: Blueprint events and their dispatch modes, versions
+ * and the change journal, registry pinning, cooldowns, tracing and equipped item instances.
+ *
+ * The core holds raw item pointers. An owner storing UObject items must report them to the garbage collector, a UObject
+ * owner from its AddReferencedObjects and anything else through an FGCObject, by calling AddReferencedObjects below.
+ *
+ * The event sink is told about every change after storage has been updated. For items it receives a copy of the old
+ * slot and a pointer to the new slot, null once the item was removed. It may modify the new slot, the pointer is only
+ * valid until the inventory next changes.
+ */
+template<typename Policy>
+class TInventoryCore
+{
+public:
+
+	using ItemType = typename Policy::ItemType;
+	using SlotType = typename Policy::SlotType;
+	using EquipmentSlotType = typename Policy::EquipmentSlotType;
+	using EventSinkType = typename Policy::EventSinkType;
+
+	using FItemStorage = TInventoryInlineMap<ItemType*, SlotType, Policy::InlineItemCapacity>;
+	using FEquipmentStorage = TInventoryInlineMap<EquipmentSlotType, ItemType*, Policy::InlineEquipmentCapacity>;
+
+	static_assert(Policy::MaxItems >= 0, "TInventoryCore policies need a MaxItems of 0 (no limit) or more");
+	static_assert(Policy::UnlimitedStackCount > 0, "TInventoryCore policies need a positive UnlimitedStackCount");
+
+	explicit TInventoryCore(const EventSinkType& InEventSink = EventSinkType())
+		: EventSink(InEventSink)
+	{
+	}
+
+	/* Adds to an item's stack within its stack limit, returns how much the stack count changed */
+	int32 AddItem(ItemType* Item, int32 StackCount)
+	{
+		if(!Item || StackCount <= 0)
+		{
+			return 0;
+		}
+
+		SlotType* Slot = Items.Find(Item);
+		if(!Slot && Policy::MaxItems > 0 && Items.Num() >= Policy::MaxItems)
+		{
+			return 0;
+		}
+
+		const SlotType OldSlot = Slot ? *Slot : SlotType(0);
+		const int32 NewStackCount = FMath::Clamp(OldSlot.StackCount + StackCount, 0, GetStackLimit(Item));
+		if(NewStackCount == OldSlot.StackCount)
+		{
+			return 0;
+		}
+
+		SlotType& NewSlot = Slot ? *Slot : Items.Add(Item, OldSlot);
+		NewSlot.StackCount = NewStackCount;
+
+		EventSink.OnItemSlotChanged(Item, OldSlot, &NewSlot);
+		return NewStackCount - OldSlot.StackCount;
+	}
+
+	/* Takes from an item's stack, a StackCount of 0 or less takes all of it. Returns how many were taken */
+	int32 RemoveItem(ItemType* Item, int32 StackCount)
+	{
+		SlotType* Slot = Item ? Items.Find(Item) : nullptr;
+		if(!Slot || Slot->StackCount <= 0)
+		{
+			return 0;
+		}
+
+		const SlotType OldSlot = *Slot;
+		const int32 NewStackCount = StackCount <= 0 ? 0 : OldSlot.StackCount - StackCount;
+
+		if(NewStackCount > 0)
+		{
+			Slot->StackCount = NewStackCount;
+			EventSink.OnItemSlotChanged(Item, OldSlot, Slot);
+			return OldSlot.StackCount - NewStackCount;
+		}
+
+		Items.Remove(Item);
+		EventSink.OnItemSlotChanged(Item, OldSlot, static_cast<SlotType*>(nullptr));
+		return OldSlot.StackCount;
+	}
+
+	/* Applies Modifier to the slot of an item we hold, returns false if we do not hold the item */
+	template<typename ModifierType>
+	bool ModifySlot(ItemType* Item, ModifierType&& Modifier)
+	{
+		SlotType* Slot = Item ? Items.Find(Item) : nullptr;
+		if(!Slot || Slot->StackCount <= 0)
+		{
+			return false;
+		}
+
+		const SlotType OldSlot = *Slot;
+		Modifier(*Slot);
+		EventSink.OnItemSlotChanged(Item, OldSlot, Slot);
+		return true;
+	}
+
+	int32 GetStackCount(const ItemType* Item) const
+	{
+		const SlotType* Slot = Item ? Items.Find(const_cast<ItemType*>(Item)) : nullptr;
+		return Slot ? Slot->StackCount : 0;
+	}
+
+	bool HasItem(const ItemType* Item) const
+	{
+		return Item && Items.Contains(const_cast<ItemType*>(Item));
+	}
+
+	const SlotType* FindSlot(const ItemType* Item) const
+	{
+		return Items.Find(const_cast<ItemType*>(Item));
+	}
+
+	int32 GetStackLimit(const ItemType* Item) const
+	{
+		const int32 MaxStackCount = Policy::GetMaxStackCount(Item);
+		return MaxStackCount < 0 ? Policy::UnlimitedStackCount : MaxStackCount;
+	}
+
+	/* Appends every item Predicate accepts to OutItems, returns how many were appended */
+	template<typename PredicateType>
+	int32 GetItems(TArray<ItemType*>& OutItems, PredicateType&& Predicate) const
+	{
+		const int32 NumItems = OutItems.Num();
+		for(ItemType* Item : Items.GetKeys())
+		{
+			if(Predicate(Item))
+			{
+				OutItems.Add(Item);
+			}
+		}
+
+		return OutItems.Num() - NumItems;
+	}
+
+	/* Adds an empty equipment slot, returns false if it already exists */
+	bool AddEquipmentSlot(const EquipmentSlotType& EquippedSlot)
+	{
+		if(Equipment.Contains(EquippedSlot))
+		{
+			return false;
+		}
+
+		Equipment.Add(EquippedSlot, nullptr);
+		return true;
+	}
+
+	bool HasEquipmentSlot(const EquipmentSlotType& EquippedSlot) const
+	{
+		return Equipment.Contains(EquippedSlot);
+	}
+
+	ItemType* GetItemAtEquipmentSlot(const EquipmentSlotType& EquippedSlot) const
+	{
+		ItemType* const* Item = Equipment.Find(EquippedSlot);
+		return Item ? *Item : nullptr;
+	}
+
+	/* First equipment slot holding Item, false if it is not equipped */
+	bool FindEquippedSlot(const ItemType* Item, EquipmentSlotType& OutSlot) const
+	{
+		const int32 Index = Item ? Equipment.GetValues().Find(const_cast<ItemType*>(Item)) : INDEX_NONE;
+		if(Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		OutSlot = Equipment.GetKeyAt(Index);
+		return true;
+	}
+
+	/* First empty equipment slot of a slot type, matched against the slot's SlotType member as FEquippedSlot has */
+	template<typename SlotTypeKeyType>
+	bool FindEmptyEquipmentSlot(const SlotTypeKeyType& SlotTypeKey, EquipmentSlotType& OutSlot) const
+	{
+		for(int32 Index = 0; Index < Equipment.Num(); Index++)
+		{
+			if(!Equipment.GetValueAt(Index) && Equipment.GetKeyAt(Index).SlotType == SlotTypeKey)
+			{
+				OutSlot = Equipment.GetKeyAt(Index);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* Highest SlotNumber among the equipment slots of a slot type, INDEX_NONE if there are none */
+	template<typename SlotTypeKeyType>
+	int32 GetHighestEquipmentSlotNumber(const SlotTypeKeyType& SlotTypeKey) const
+	{
+		int32 HighestSlotNumber = INDEX_NONE;
+		for(const EquipmentSlotType& EquippedSlot : Equipment.GetKeys())
+		{
+			if(EquippedSlot.SlotType == SlotTypeKey)
+			{
+				HighestSlotNumber = FMath::Max(HighestSlotNumber, EquippedSlot.SlotNumber);
+			}
+		}
+
+		return HighestSlotNumber;
+	}
+
+	/* Stores an item in an equipment slot, adding the slot if needed. Returns the item stored there before */
+	ItemType* SetItemInEquipmentSlot(const EquipmentSlotType& EquippedSlot, ItemType* Item)
+	{
+		ItemType*& SlotItem = Equipment.FindOrAdd(EquippedSlot);
+		ItemType* OldItem = SlotItem;
+		SlotItem = Item;
+
+		if(OldItem != Item)
+		{
+			EventSink.OnEquipmentSlotChanged(EquippedSlot, OldItem, Item);
+		}
+
+		return OldItem;
+	}
+
+	FItemStorage& GetItemStorage() { return Items; }
+	const FItemStorage& GetItemStorage() const { return Items; }
+
+	FEquipmentStorage& GetEquipmentStorage() { return Equipment; }
+	const FEquipmentStorage& GetEquipmentStorage() const { return Equipment; }
+
+	EventSinkType& GetEventSink() { return EventSink; }
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Items.GetAllocatedSize() + Equipment.GetAllocatedSize();
+	}
+
+	/* Reports every stored item and what their slots reference to the garbage collector */
+	void AddReferencedObjects(FReferenceCollector& Collector, const UObject* ReferencingObject = nullptr)
+	{
+		for(int32 Index = 0; Index < Items.Num(); Index++)
+		{
+			Collector.AddReferencedObject(Items.GetKeyAtForReferenceCollection(Index), ReferencingObject);
+		}
+
+		AddSlotReferencedObjects(Collector, ReferencingObject);
+
+		for(ItemType*& Item : Equipment.GetValues())
+		{
+			Collector.AddReferencedObject(Item, ReferencingObject);
+		}
+	}
+
+	/* Reports only what the slots reference besides their items, for owners keeping the items alive some other way */
+	void AddSlotReferencedObjects(FReferenceCollector& Collector, const UObject* ReferencingObject = nullptr)
+	{
+		for(SlotType& Slot : Items.GetValues())
+		{
+			Policy::AddSlotReferencedObjects(Slot, Collector, ReferencingObject);
+		}
+	}
+
+private:
+
+	FItemStorage Items;
+
+	FEquipmentStorage Equipment;
+
+	EventSinkType EventSink;
+};
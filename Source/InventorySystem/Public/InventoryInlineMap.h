@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Small map used for per component inventory storage.
+ *
+ * Keys and values live in two parallel arrays with inline storage for InlineCapacity entries, so small inventories
+ * need no heap allocation and lookups are a linear scan over a contiguous key array. Once the map grows past
+ * InlineCapacity entries the arrays spill to the heap and a hash index is built, lookups then go through the index.
+ * The index is dropped again once the map shrinks back to half the threshold.
+ *
+ * Removal swaps the last entry into the removed index, so iteration order is not stable across removals.
+ * Not reflected, owners are responsible for reporting any object references to the garbage collector. Keys handed out
+ * through GetKeyAtForReferenceCollection may be cleared by the collector, the hash index is rebuilt on the next change
+ * and lookups never trust an index entry whose key no longer matches.
+ */
+template<typename KeyType, typename ValueType, int32 InlineCapacity = 8>
+class TInventoryInlineMap
+{
+	static_assert(InlineCapacity > 0, "TInventoryInlineMap needs an inline capacity of at least one entry");
+
+public:
+
+	int32 Num() const { return Keys.Num(); }
+
+	bool IsEmpty() const { return Keys.IsEmpty(); }
+
+	/* True if the map has outgrown its inline storage and lookups go through the hash index */
+	bool IsUsingHashIndex() const { return !HashIndex.IsEmpty(); }
+
+	int32 IndexOf(const KeyType& Key) const
+	{
+		if(IsUsingHashIndex())
+		{
+			// Entries for keys the garbage collector cleared are only dropped on the next rebuild
+			const int32* FoundIndex = HashIndex.Find(Key);
+			return FoundIndex && Keys.IsValidIndex(*FoundIndex) && Keys[*FoundIndex] == Key ? *FoundIndex : INDEX_NONE;
+		}
+
+		const KeyType* KeyData = Keys.GetData();
+		for(int32 Index = 0, Count = Keys.Num(); Index < Count; Index++)
+		{
+			if(KeyData[Index] == Key)
+			{
+				return Index;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	bool Contains(const KeyType& Key) const { return IndexOf(Key) != INDEX_NONE; }
+
+	ValueType* Find(const KeyType& Key)
+	{
+		const int32 Index = IndexOf(Key);
+		return Index != INDEX_NONE ? &Values[Index] : nullptr;
+	}
+
+	const ValueType* Find(const KeyType& Key) const
+	{
+		const int32 Index = IndexOf(Key);
+		return Index != INDEX_NONE ? &Values[Index] : nullptr;
+	}
+
+	ValueType& FindChecked(const KeyType& Key)
+	{
+		const int32 Index = IndexOf(Key);
+		check(Index != INDEX_NONE);
+		return Values[Index];
+	}
+
+	/* Adds the key or overwrites the value of an existing key */
+	ValueType& Add(const KeyType& Key, const ValueType& Value)
+	{
+		ValueType& Existing = FindOrAdd(Key);
+		Existing = Value;
+		return Existing;
+	}
+
+	/* Adds the key with a default constructed value, or the existing value if it has one */
+	ValueType& Add(const KeyType& Key)
+	{
+		return FindOrAdd(Key);
+	}
+
+	ValueType& FindOrAdd(const KeyType& Key)
+	{
+		RepairHashIndex();
+
+		const int32 ExistingIndex = IndexOf(Key);
+		if(ExistingIndex != INDEX_NONE)
+		{
+			return Values[ExistingIndex];
+		}
+
+		const int32 NewIndex = Keys.Add(Key);
+		Values.Emplace();
+
+		if(IsUsingHashIndex())
+		{
+			HashIndex.Add(Key, NewIndex);
+		}
+		else if(Keys.Num() > InlineCapacity)
+		{
+			RebuildHashIndex();
+		}
+
+		return Values[NewIndex];
+	}
+
+	bool Remove(const KeyType& Key)
+	{
+		const int32 Index = IndexOf(Key);
+		if(Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		RemoveAt(Index);
+		return true;
+	}
+
+	void RemoveAt(int32 Index)
+	{
+		check(Keys.IsValidIndex(Index));
+		RepairHashIndex();
+
+		const int32 LastIndex = Keys.Num() - 1;
+		if(IsUsingHashIndex())
+		{
+			HashIndex.Remove(Keys[Index]);
+			if(Index != LastIndex)
+			{
+				HashIndex.Add(Keys[LastIndex], Index);
+			}
+		}
+
+		Keys.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		Values.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+		// Drop back to linear lookups with some hysteresis so we do not rebuild the index on every add / remove
+		if(IsUsingHashIndex() && Keys.Num() <= InlineCapacity / 2)
+		{
+			HashIndex.Empty();
+		}
+	}
+
+	void Reserve(int32 Number)
+	{
+		Keys.Reserve(Number);
+		Values.Reserve(Number);
+	}
+
+	void Empty()
+	{
+		Keys.Empty();
+		Values.Empty();
+		HashIndex.Empty();
+		bHashIndexMayBeStale = false;
+	}
+
+	const KeyType& GetKeyAt(int32 Index) const { return Keys[Index]; }
+
+	/* Mutable key access for reference collection, only the garbage collector may change the key and only to null */
+	KeyType& GetKeyAtForReferenceCollection(int32 Index)
+	{
+		bHashIndexMayBeStale = IsUsingHashIndex();
+		return Keys[Index];
+	}
+
+	ValueType& GetValueAt(int32 Index) { return Values[Index]; }
+
+	const ValueType& GetValueAt(int32 Index) const { return Values[Index]; }
+
+	TConstArrayView<KeyType> GetKeys() const { return Keys; }
+
+	TArrayView<ValueType> GetValues() { return Values; }
+
+	TConstArrayView<ValueType> GetValues() const { return Values; }
+
+	/* Replaces the contents of OutKeys like TMap::GetKeys does */
+	void GetKeys(TArray<KeyType>& OutKeys) const
+	{
+		OutKeys.Reset(Keys.Num());
+		OutKeys.Append(Keys);
+	}
+
+	/* Heap memory owned by this map, inline storage is part of the owner and not counted */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Keys.GetAllocatedSize() + Values.GetAllocatedSize() + HashIndex.GetAllocatedSize();
+	}
+
+private:
+
+	void RebuildHashIndex()
+	{
+		HashIndex.Empty(Keys.Num());
+		for(int32 Index = 0; Index < Keys.Num(); Index++)
+		{
+			HashIndex.Add(Keys[Index], Index);
+		}
+
+		bHashIndexMayBeStale = false;
+	}
+
+	/* Drops index entries for keys cleared by the garbage collector before they can be moved around by a change */
+	void RepairHashIndex()
+	{
+		if(bHashIndexMayBeStale)
+		{
+			RebuildHashIndex();
+		}
+	}
+
+	TArray<KeyType, TInlineAllocator<InlineCapacity>> Keys;
+
+	TArray<ValueType, TInlineAllocator<InlineCapacity>> Values;
+
+	TMap<KeyType, int32> HashIndex;
+
+	// Set once keys have been handed to the garbage collector while the hash index was in use
+	bool bHashIndexMayBeStale = false;
+};
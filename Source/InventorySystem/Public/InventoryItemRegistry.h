@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "InventoryItemRegistry.generated.h"
+
+class UItem;
+
+/**
+ * Single rooted list of every item stored by inventory components that pin their items, see bPinItemsInRegistry.
+ *
+ * Each distinct item holds one entry with a reference count and a stable index, so the garbage collector reaches every
+ * pinned item through this one array instead of walking the slots of each inventory on every pass. An item is released
+ * once the last slot referencing it is emptied.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryItemRegistry : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UInventoryItemRegistry* Get();
+
+	/* Keeps an item alive until it is unpinned as many times as it was pinned, returns its stable index */
+	int32 PinItem(UItem* Item);
+
+	void UnpinItem(UItem* Item);
+
+	/* Item pinned at an index, null if nothing is pinned there */
+	UItem* GetItem(int32 Index) const;
+
+	int32 IndexOf(const UItem* Item) const;
+
+	int32 GetNumPinnedItems() const;
+
+	virtual void Deinitialize() override;
+
+protected:
+
+	// Pinned items by index, released indices are null until reused
+	UPROPERTY(Transient)
+	TArray<UItem*> Items;
+
+	TArray<int32> RefCounts;
+
+	TMap<const UItem*, int32> ItemIndices;
+
+	TArray<int32> FreeIndices;
+};
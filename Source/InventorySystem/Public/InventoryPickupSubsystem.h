@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InventoryPickupSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UInventorySystemComponent;
+class UItem;
+class UStaticMesh;
+
+/* Handle to an item stack lying in the world, stays safe to use after the drop was picked up */
+USTRUCT(BlueprintType)
+struct FInventoryDropHandle
+{
+	GENERATED_BODY()
+
+	FInventoryDropHandle()
+	{
+		Index = INDEX_NONE;
+		Serial = 0;
+	}
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Index;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Serial;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FInventoryDropHandle& Other) const { return Index == Other.Index && Serial == Other.Serial; }
+};
+
+/* Sphere to search for drops in, one of a batch passed to QueryDropsInRadii */
+struct FInventoryDropQuery
+{
+	FVector Center = FVector::ZeroVector;
+	float Radius = 0.f;
+};
+
+/**
+ * Item stacks lying in the world, stored as plain data in a uniform grid spatial hash rather than as actors.
+ *
+ * Drops are bucketed into square cells on the XY plane. A radius query only visits the cells its sphere overlaps, so
+ * its cost follows the number of drops nearby rather than the number in the world. Items are kept alive through the
+ * shared item registry if it exists when the world is created, otherwise they are reported to the garbage collector.
+ * Drops of items with a PickupMesh are optionally drawn through one instanced static mesh per mesh.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryPickupSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryPickupSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	/* Drops a stack of an item at a location, the location is also written to the state data's LocationData */
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	FInventoryDropHandle DropItem(UItem* Item, int32 StackCount, FItemStateData StateData, FVector Location);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	bool RemoveDrop(FInventoryDropHandle Handle);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	bool MoveDrop(FInventoryDropHandle Handle, FVector NewLocation);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory | Pickups")
+	bool IsDropValid(FInventoryDropHandle Handle) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	bool GetDrop(FInventoryDropHandle Handle, UItem*& OutItem, int32& OutStackCount, FItemStateData& OutStateData) const;
+
+	/* Adds as much of the drop to the inventory as it accepts, whatever does not fit stays in the world.
+	 * Returns the number of items picked up */
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	int32 PickupDrop(FInventoryDropHandle Handle, UInventorySystemComponent* InventorySystemComponent);
+
+	/* Appends every drop within Radius of Center to OutDrops */
+	UFUNCTION(BlueprintCallable, Category = "Inventory | Pickups")
+	void QueryDropsInRadius(FVector Center, float Radius, TArray<FInventoryDropHandle>& OutDrops) const;
+
+	/* Answers a batch of queries into one shared array, the drops of query i are OutDrops[OutQueryStarts[i]] up to the
+	 * start of the next query. Meant for the players and AI polling for nearby drops every frame */
+	void QueryDropsInRadii(TConstArrayView<FInventoryDropQuery> Queries, TArray<FInventoryDropHandle>& OutDrops, TArray<int32>& OutQueryStarts) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory | Pickups")
+	int32 GetNumDrops() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+
+	struct FWorldDrop
+	{
+		UItem* Item = nullptr;
+		int32 StackCount = 0;
+		FItemStateData StateData;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		int32 PrevInCell = INDEX_NONE;
+		// Next drop in the same cell, or the next free drop once this one is released
+		int32 NextInCell = INDEX_NONE;
+		int32 ProxyInstance = INDEX_NONE;
+		int32 Serial = 0;
+		bool bActive = false;
+	};
+
+	/* Instanced mesh drawing every drop of items sharing a pickup mesh */
+	struct FDropProxy
+	{
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Component;
+		// Drop drawn by each instance, kept in step with the component's swap removal
+		TArray<int32> InstanceDrops;
+	};
+
+	FWorldDrop* FindDrop(const FInventoryDropHandle& Handle);
+	const FWorldDrop* FindDrop(const FInventoryDropHandle& Handle) const;
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void LinkToCell(int32 DropIndex);
+	void UnlinkFromCell(int32 DropIndex);
+
+	void GatherDropsInRadius(const FVector& Center, float Radius, TArray<FInventoryDropHandle>& OutDrops) const;
+
+	void GatherDropsInCell(int32 DropIndex, const FVector& Center, float RadiusSquared, TArray<FInventoryDropHandle>& OutDrops) const;
+
+	void AddProxyInstance(int32 DropIndex);
+	void RemoveProxyInstance(int32 DropIndex);
+	void UpdateProxyInstance(int32 DropIndex);
+
+	void ReleaseDrop(int32 DropIndex);
+
+	TArray<FWorldDrop> Drops;
+
+	TMap<FIntPoint, int32> CellHeads;
+
+	int32 FreeList;
+
+	int32 NumDrops;
+
+	// Drops whose state data references an optional object, the only references we report ourselves while items are pinned
+	int32 NumOptionalObjectReferences;
+
+	// Whether our drops' items are kept alive by the item registry. Decided once when we are initialized, so a registry
+	// created or destroyed later never leaves a drop neither pinned nor reported, or pinned and never unpinned
+	bool bItemsPinned;
+
+	// Edge length of a grid cell, fixed when the subsystem is created
+	float CellSize;
+
+	bool bRenderProxies;
+
+	TMap<const UStaticMesh*, FDropProxy> Proxies;
+
+	UPROPERTY(Transient)
+	AActor* ProxyActor;
+};
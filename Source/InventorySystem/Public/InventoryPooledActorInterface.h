@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "InventoryPooledActorInterface.generated.h"
+
+class UItem;
+
+// This class does not need to be modified.
+UINTERFACE(BlueprintType, Blueprintable)
+class UInventoryPooledActorInterface : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Optional interface for item instance actors spawned through the inventory actor pool, lets an actor reset any state
+ * it picked up while equipped before it is handed to the next item.
+ */
+class INVENTORYSYSTEM_API IInventoryPooledActorInterface
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called after the actor was taken out of the pool and shown again, Item is the item it now represents */
+	UFUNCTION(BlueprintNativeEvent, Category = "Inventory | Actor Pool")
+	void OnAcquiredFromPool(UItem* Item);
+
+	/* Called before the actor is hidden and returned to the pool */
+	UFUNCTION(BlueprintNativeEvent, Category = "Inventory | Actor Pool")
+	void OnReleasedToPool();
+};
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "InventoryReplayCommandlet.generated.h"
+
+/**
+ * Replays an inventory trace recorded with Inventory.Trace.Start against fresh components in an empty world, and reports
+ * throughput, per operation latency histograms and a checksum of the final inventory state.
+ *
+ * Usage: UnrealEditor-Cmd <Project> -run=InventoryReplay -Trace=<File> [-FrameTime=<Seconds>] -nullrhi -unattended
+ *
+ * Each recorded component is replaced by a new component on an empty actor, so a trace should be started before the
+ * components it captures are initialized for the replayed state to match the recorded one. The world is ticked whenever
+ * the recorded frame changes, each frame taking FrameTime (1/60 s by default) as traces do not record delta times.
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+
+	// Items and optional objects referenced by the trace, kept alive for the duration of the replay
+	UPROPERTY()
+	TArray<UObject*> LoadedObjects;
+};
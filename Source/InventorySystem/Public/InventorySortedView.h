@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemTypes.h"
+#include "UObject/Object.h"
+#include "InventorySortedView.generated.h"
+
+class UInventorySystemComponent;
+class UItem;
+
+UENUM(BlueprintType)
+enum class EInventoryViewSortKey : uint8
+{
+	Name,
+	Type,
+	StackCount
+};
+
+UENUM(BlueprintType)
+enum class EInventoryViewChangeType : uint8
+{
+	// A row was inserted at Index, rows at and after Index move down by one
+	Insert,
+	// The row at Index was removed, rows after Index move up by one
+	Remove,
+	// The row at Index stayed in place but its data changed
+	Update
+};
+
+USTRUCT(BlueprintType)
+struct FInventoryViewChange
+{
+	GENERATED_BODY()
+
+	FInventoryViewChange()
+	{
+		ChangeType = EInventoryViewChangeType::Update;
+		Index = INDEX_NONE;
+		Item = nullptr;
+	}
+
+	FInventoryViewChange(EInventoryViewChangeType InChangeType, int32 InIndex, UItem* InItem)
+	{
+		ChangeType = InChangeType;
+		Index = InIndex;
+		Item = InItem;
+	}
+
+	UPROPERTY(BlueprintReadOnly)
+	EInventoryViewChangeType ChangeType;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Index;
+
+	UPROPERTY(BlueprintReadOnly)
+	UItem* Item;
+};
+
+/* A row of a sorted view and its node in the view's order statistic tree */
+USTRUCT()
+struct FInventoryViewEntry
+{
+	GENERATED_BODY()
+
+	FInventoryViewEntry()
+	{
+		Item = nullptr;
+		StackCount = 0;
+		Left = INDEX_NONE;
+		Right = INDEX_NONE;
+		Size = 1;
+		Priority = 0;
+	}
+
+	// Null while the entry is on the free list
+	UPROPERTY()
+	UItem* Item;
+
+	/* Sort keys as they were when the entry was last positioned. The tree is ordered by these rather than by the live
+	 * item, so editing an item can never leave the tree out of order before the view has moved its row */
+	int32 StackCount;
+
+	FName SortName;
+
+	FName ObjectName;
+
+	// Children in the view's entry array, INDEX_NONE for none
+	int32 Left;
+
+	int32 Right;
+
+	// Number of entries in the subtree rooted here, gives the row index of an entry in O(log n)
+	int32 Size;
+
+	// Heap priority keeping the tree balanced in expectation
+	uint32 Priority;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryViewChanged, const TArray<FInventoryViewChange>&, Changes);
+
+/**
+ * Sorted, optionally filtered view over the items of an inventory component.
+ *
+ * The order is built once on creation and then kept up to date from the component's item changed events. Rows are
+ * kept in a treap with subtree sizes, so inserting, removing or finding the index of a row and reading the row at an
+ * index are all O(log n) and a page of k rows costs O(log n + k). Each change is reported as a minimal list of
+ * positional inserts / removes, so list widgets can patch only the affected rows and read the visible page through GetPage.
+ *
+ * Rows are ordered by the name, type and stack count they had when they were last positioned. Renaming or retyping an
+ * item in the editor or through UItem::SetItemName / SetItemType moves its row, other edits need a call to RefreshItem.
+ */
+UCLASS(BlueprintType)
+class INVENTORYSYSTEM_API UInventorySortedView : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Creates a view over the inventory of a component. An invalid TypeFilter includes every item type */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System | View", meta = (AutoCreateRefTerm = "TypeFilter"))
+	static UInventorySortedView* CreateSortedView(UInventorySystemComponent* InventorySystemComponent, EInventoryViewSortKey SortKey, const FPrimaryAssetType& TypeFilter, bool bDescending = false);
+
+	/* Stops listening to the component, the view keeps its last known order */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System | View")
+	void Release();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System | View")
+	int32 Num() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System | View")
+	UItem* GetItemAt(int32 Index) const;
+
+	/* Returns the position of an item in the view or INDEX_NONE if the view does not contain it */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System | View")
+	int32 IndexOf(UItem* Item) const;
+
+	/* Copies the rows of a single page into OutItems, returns the number of rows copied */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System | View")
+	int32 GetPage(int32 PageIndex, int32 PageSize, TArray<UItem*>& OutItems) const;
+
+	/* Moves the item's row to match its current name, type and stack count */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System | View")
+	void RefreshItem(UItem* Item);
+
+	UPROPERTY(BlueprintAssignable)
+	FOnInventoryViewChanged OnViewChanged;
+
+	virtual void BeginDestroy() override;
+
+protected:
+
+	UFUNCTION()
+	void HandleItemChanged(UItem* Item, EInventorySlotChangeType ChangeType);
+
+	void HandleItemSortKeysChanged(UItem* Item);
+
+	/* Brings the item's row in line with the component, returns the changes made */
+	void UpdateItem(UItem* Item, TArray<FInventoryViewChange, TInlineAllocator<2>>& OutChanges);
+
+	bool PassesFilter(const UItem* Item) const;
+
+	/* Copies the item's current sort keys into an entry */
+	void SnapshotSortKeys(FInventoryViewEntry& Entry, int32 StackCount) const;
+
+	/* Strict weak ordering of two entries for the current sort settings, ties are broken by object name and address */
+	bool IsOrderedBefore(const FInventoryViewEntry& A, const FInventoryViewEntry& B) const;
+
+	/* Order statistic tree operations, all O(log n) in expectation */
+
+	int32 GetSubtreeSize(int32 EntryIndex) const;
+
+	void UpdateSubtreeSize(int32 EntryIndex);
+
+	/* Splits a subtree into the entries ordered before Key and the rest */
+	void Split(int32 EntryIndex, const FInventoryViewEntry& Key, int32& OutLeft, int32& OutRight);
+
+	/* Joins two subtrees where every entry of Left is ordered before every entry of Right */
+	int32 Merge(int32 Left, int32 Right);
+
+	/* Links an allocated entry into the tree, returns its row index */
+	int32 LinkEntry(int32 EntryIndex);
+
+	/* Unlinks an entry from the tree, the entry stays allocated */
+	int32 UnlinkEntry(int32 Subtree, int32 EntryIndex);
+
+	/* Row index of an entry that is in the tree */
+	int32 GetRowIndex(int32 EntryIndex) const;
+
+	int32 AllocateEntry(UItem* Item);
+
+	void FreeEntry(int32 EntryIndex);
+
+	UPROPERTY()
+	TWeakObjectPtr<UInventorySystemComponent> InventorySystemComponent;
+
+	// Pool of tree nodes, freed entries are reused through FreeEntries
+	UPROPERTY()
+	TArray<FInventoryViewEntry> Entries;
+
+	TArray<int32> FreeEntries;
+
+	// Entry of every item in the view
+	TMap<const UItem*, int32> EntryIndices;
+
+	int32 RootEntry = INDEX_NONE;
+
+	uint32 PrioritySeed = 0x9E3779B9u;
+
+	EInventoryViewSortKey SortKey;
+
+	FPrimaryAssetType TypeFilter;
+
+	bool bDescending;
+};
@@ -3,9 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "InventoryCore.h"
+#include "InventoryInlineMap.h"
+#include "InventoryTimerWheel.h"
 #include "Item.h"
 #include "ItemTypes.h"
 #include "Components/ActorComponent.h"
+#include "HAL/CriticalSection.h"
+#include "UObject/ObjectKey.h"
 #include "InventorySystemComponent.generated.h"
 
 
@@ -13,12 +18,140 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemChanged, UItem*, Item, EInve
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemStackCountChanged, int, OldStackCount, int, NewStackCount);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnEquipmentSlotChanged, FEquippedSlot, EquippedSlotData, UItem*, Item, EEquipmentSlotChangeType, ChangeType);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEquipmentSlotUsed, FEquippedSlot, EquippedSlot, UItem*, Item);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEquipmentLoadoutApplied, FName, LoadoutName, const TArray<FEquippedSlot>&, ChangedSlots);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnEquipmentSlotUseStateChanged, FEquippedSlot, EquippedSlot, int32, Charges, bool, bOnCooldown);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryChangesAvailable, int64, LatestVersion);
+
+class FInventoryCommandChannel;
+struct FInventoryCommand;
+class UInventoryCooldownSubsystem;
+class UInventorySystemComponent;
+enum class EInventoryCooldownTimerType : uint8;
+
+UENUM(BlueprintType)
+enum class EInventoryEventDispatchMode : uint8
+{
+	// Events are broadcast as soon as the inventory changes, one per call and in the order they always were
+	Immediate,
+	// Changes are collapsed per item and equipment slot and broadcast once per frame at the event flush tick group
+	Deferred
+};
+
+/* Cooldown and charge state of an item used from an equipment slot, only tracked while it has something left to recover */
+struct FEquipmentSlotUseState
+{
+	int32 Charges = 0;
+	FInventoryTimerHandle CooldownTimer;
+	FInventoryTimerHandle ChargeRecoveryTimer;
+};
+
+/* Use state is kept per item and slot, so taking an item out of its slot and putting it back cannot reset its cooldown or charges */
+struct FEquipmentSlotUseStateKey
+{
+	FEquippedSlot EquippedSlot;
+	TObjectKey<UItem> Item;
+
+	FEquipmentSlotUseStateKey() = default;
+
+	FEquipmentSlotUseStateKey(const FEquippedSlot& InEquippedSlot, TObjectKey<UItem> InItem)
+		: EquippedSlot(InEquippedSlot)
+		, Item(InItem)
+	{
+	}
+
+	bool operator==(const FEquipmentSlotUseStateKey& Other) const
+	{
+		return EquippedSlot == Other.EquippedSlot && Item == Other.Item;
+	}
+
+	friend uint32 GetTypeHash(const FEquipmentSlotUseStateKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.EquippedSlot), GetTypeHash(Key.Item));
+	}
+};
+
+/* Breakdown of the heap memory owned by a single inventory component */
+USTRUCT(BlueprintType)
+struct FInventoryMemoryStats
+{
+	GENERATED_BODY()
+
+	FInventoryMemoryStats()
+	{
+		NumItems = 0;
+		NumEquipmentSlots = 0;
+		SlotBytes = 0;
+		EquipmentBytes = 0;
+		DelegateBytes = 0;
+		StateDataBytes = 0;
+	}
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumItems;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumEquipmentSlots;
+
+	// Heap allocated by the inventory storage, excluding the item state data stored inside each slot
+	UPROPERTY(BlueprintReadOnly)
+	int64 SlotBytes;
+
+	// Heap allocated by the equipment storage
+	UPROPERTY(BlueprintReadOnly)
+	int64 EquipmentBytes;
+
+	// Stack count changed map, the invocation lists of every delegate we own and the change journal kept for viewers
+	UPROPERTY(BlueprintReadOnly)
+	int64 DelegateBytes;
+
+	// Item state data stored inside heap allocated inventory slots
+	UPROPERTY(BlueprintReadOnly)
+	int64 StateDataBytes;
+
+	int64 GetTotalBytes() const { return SlotBytes + EquipmentBytes + DelegateBytes + StateDataBytes; }
+};
+
+/* Forwards changes made by the component's inventory core back to the component */
+struct FInventorySystemComponentEventSink
+{
+	UInventorySystemComponent* Owner = nullptr;
+
+	void OnItemSlotChanged(UItem* Item, const FInventorySlotData& OldSlot, FInventorySlotData* NewSlot);
+
+	void OnEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem);
+};
+
+/* Inventory core policy of UInventorySystemComponent, stack limits still go through UItem::GetMaxStackCount as Blueprint items may override it */
+struct FInventorySystemComponentPolicy : FInventoryCorePolicyBase
+{
+	using ItemType = UItem;
+	using EventSinkType = FInventorySystemComponentEventSink;
+
+	static int32 GetMaxStackCount(const UItem* Item) { return Item->GetMaxStackCount(); }
+};
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class INVENTORYSYSTEM_API UInventorySystemComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
+public:
+
+	/* Number of items / equipment slots / stack count listeners kept inline before storage falls back to the heap and a hash index */
+	static constexpr int32 InlineItemCapacity = FInventorySystemComponentPolicy::InlineItemCapacity;
+	static constexpr int32 InlineEquipmentCapacity = FInventorySystemComponentPolicy::InlineEquipmentCapacity;
+	static constexpr int32 InlineStackCountListenerCapacity = 4;
+
+	using FInventoryCore = TInventoryCore<FInventorySystemComponentPolicy>;
+	using FInventoryStorage = FInventoryCore::FItemStorage;
+	using FEquipmentStorage = FInventoryCore::FEquipmentStorage;
+	using FStackCountListenerStorage = TInventoryInlineMap<const UItem*, FOnItemStackCountChanged, InlineStackCountListenerCapacity>;
+	using FItemChangeStorage = TInventoryInlineMap<UItem*, int32, InlineItemCapacity>;
+	using FEquipmentChangeStorage = TInventoryInlineMap<FEquippedSlot, UItem*, InlineEquipmentCapacity>;
+
+	UInventorySystemComponent();
+
+private:
 
 	// Owning actor of our component
 	UPROPERTY()
@@ -30,8 +163,12 @@ class INVENTORYSYSTEM_API UInventorySystemComponent : public UActorComponent
 	
 protected:
 
-	// Map of Item Data to Inventory Data such as stack count
-	UPROPERTY(BlueprintReadOnly, Category = "Inventory System Component | Items")
+	// Items with their inventory slots and equipment slots with their items, references are reported in AddReferencedObjects
+	FInventoryCore InventoryCore;
+
+	/* Copy of our items for Blueprints and subclasses written against the old TMap storage, updated on every change while
+	 * bMirrorLegacyMaps is set. Its references are reported like any property, pinned items included */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System Component | Items", meta = (DeprecatedProperty, DeprecationMessage = "Use GetInventoryMap instead, this copy stays empty once bMirrorLegacyMaps is turned off"))
 	TMap<UItem*, FInventorySlotData> InventoryMap;
 	
 	/* Array of Item Classes to grant our Component when initialized
@@ -44,10 +181,22 @@ protected:
 	UPROPERTY(BlueprintAssignable)
 	FOnItemChanged OnItemChanged;
 
+	/* Keeps our items alive through the shared item registry instead of reporting every slot to the garbage collector,
+	 * worth turning on for classes with many instances such as NPC inventories. Components created before the registry
+	 * exists report their items as usual */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System Component | Memory")
+	bool bPinItemsInRegistry;
+
+	/* Keeps the deprecated InventoryMap and EquipmentMap properties up to date. Turn it off once nothing reads them to
+	 * drop the duplicate storage and the garbage collector references that come with it */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System Component | Memory")
+	bool bMirrorLegacyMaps;
+
 public:
 
-	UPROPERTY()
-	TMap<const UItem*, FOnItemStackCountChanged> ItemStackCountChangedMap;
+	/* Stack count listeners per item. This used to be a TMap: Find, FindOrAdd, Add, Remove, Contains and Num work as they
+	 * did, ranged for over pairs does not, iterate GetKeys or GetValues instead */
+	FStackCountListenerStorage ItemStackCountChangedMap;
 
 public:
 
@@ -75,6 +224,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Items")
 	int GetItemStackCount(const UItem* Item);
 
+	/* Copy of every item we hold with its slot, replaces reading the deprecated InventoryMap property */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Items")
+	TMap<UItem*, FInventorySlotData> GetInventoryMap() const;
+
 	/** Initializes our Default Inventory Items
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Defaults")
@@ -93,11 +246,48 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Initialize")
 	void InitActorInfo(AActor* InOwningActor, AActor* InAvatarActor);
 
+	/* Returns the heap memory this component owns, split by what it is used for */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Debug")
+	FInventoryMemoryStats GetMemoryStats() const;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	virtual void PostInitProperties() override;
+
+	virtual void BeginDestroy() override;
+
 protected:
 
 	UFUNCTION()
 	bool GetInventorySlotForItem(UItem* Item, FInventorySlotData& InventorySlot);
 
+	/* Pins an item that just entered our inventory or an equipment slot when our items are pinned */
+	void PinItem(UItem* Item);
+
+	void UnpinItem(UItem* Item);
+
+	/* Called by our inventory core after an item's slot changed, NewSlot is null once the item was removed */
+	void HandleItemSlotChanged(UItem* Item, const FInventorySlotData& OldSlot, FInventorySlotData* NewSlot);
+
+	/* Called by our inventory core after the item stored in an equipment slot changed */
+	void HandleEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem);
+
+	/* Writes an equipment slot to the deprecated EquipmentMap while bMirrorLegacyMaps is set */
+	void MirrorEquipmentSlot(const FEquippedSlot& EquippedSlot, UItem* Item);
+
+	friend struct FInventorySystemComponentEventSink;
+
+private:
+
+	// Slots whose state data references an optional object, these are still reported when items are pinned
+	int32 NumOptionalObjectReferences;
+
+	// Whether our items are kept alive by the item registry. Decided once when we are created, so our items are never
+	// partly pinned and partly reported to the garbage collector
+	bool bItemsPinned;
+
 
 	/**********************************************************
 	 ***                  Equipment Slots                  ****
@@ -105,8 +295,8 @@ protected:
 
 protected:
 
-	// Maps equipped slot data to the item that is stored within
-	UPROPERTY(BlueprintReadOnly, Category = "Inventory System Component | Equipment")
+	/* Copy of our equipment slots for Blueprints and subclasses written against the old TMap storage, see InventoryMap */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System Component | Equipment", meta = (DeprecatedProperty, DeprecationMessage = "Use GetEquipmentMap instead, this copy stays empty once bMirrorLegacyMaps is turned off"))
 	TMap<FEquippedSlot, UItem*> EquipmentMap;
 
 	UPROPERTY(BlueprintAssignable)
@@ -130,6 +320,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Equipment")
 	int GetTotalEquipmentSlotsOfType(FPrimaryAssetType Type);
 
+	/* Adds a new empty equipment slot, returns false if the slot is invalid or already exists */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Equipment")
+	bool AddEquipmentSlot(const FEquippedSlot& EquippedSlot);
+
+	/* Returns every equipment slot this component has, whether or not an item is stored within */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Equipment")
+	bool GetEquipmentSlots(TArray<FEquippedSlot>& OutSlots);
+
+	/* Copy of every equipment slot with the item stored within, replaces reading the deprecated EquipmentMap property */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Equipment")
+	TMap<FEquippedSlot, UItem*> GetEquipmentMap() const;
+
 	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Equipment")
 	bool IsItemEquipped(const UItem* Item, FEquippedSlot& EquippedSlot);
 
@@ -147,4 +349,370 @@ public:
 
 	UFUNCTION()
 	FOnEquipmentSlotChanged& GetEquipmentSlotChangedDelegate();
+
+protected:
+
+	/* Stores an item in an existing equipment slot without broadcasting, returns the item that was stored before */
+	UItem* SetItemInEquipmentSlot(const FEquippedSlot& EquippedSlot, UItem* Item);
+
+
+	/**********************************************************
+	 ***                 Equipment Loadouts                ****
+	 *********************************************************/
+
+protected:
+
+	/* Named snapshots of our equipment slots, can be authored as defaults or saved at runtime */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory System Component | Loadouts")
+	TMap<FName, FEquipmentLoadout> EquipmentLoadouts;
+
+	/* Broadcast once per applied loadout with every slot that changed, OnEquipmentSlotChanged is not broadcast for those slots.
+	 * Follows our event dispatch mode, when deferred a loadout applied more than once before the flush is broadcast once.
+	 * Slots changed by other calls earlier in the same deferred frame still broadcast their net change as well */
+	UPROPERTY(BlueprintAssignable)
+	FOnEquipmentLoadoutApplied OnEquipmentLoadoutApplied;
+
+public:
+
+	/* Saves what is currently stored in every equipment slot under a name, replacing any loadout with the same name */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Loadouts")
+	bool SaveEquipmentLoadout(FName LoadoutName);
+
+	/* Equips a saved loadout, only slots whose item differs are touched and OnEquipmentLoadoutApplied is the only event raised.
+	 * Items no longer in our inventory, items the slot cannot hold and items already equipped in another slot leave their slot empty */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Loadouts")
+	bool ApplyEquipmentLoadout(FName LoadoutName);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Loadouts")
+	bool RemoveEquipmentLoadout(FName LoadoutName);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Loadouts")
+	bool HasEquipmentLoadout(FName LoadoutName) const;
+
+	UFUNCTION()
+	FOnEquipmentLoadoutApplied& GetEquipmentLoadoutAppliedDelegate();
+
+
+	/**********************************************************
+	 ***              Equipment Cooldowns                  ****
+	 *********************************************************/
+
+protected:
+
+	/* Broadcast when the item in an equipment slot spends or recovers a charge, or starts or finishes a cooldown.
+	 * Follows our event dispatch mode, when deferred each slot reports the state it is in at the flush once */
+	UPROPERTY(BlueprintAssignable)
+	FOnEquipmentSlotUseStateChanged OnEquipmentSlotUseStateChanged;
+
+public:
+
+	/* True if the slot holds an item that is neither cooling down nor out of charges. Items with a cooldown or charges
+	 * cannot be used outside of a world with a cooldown subsystem, nothing would limit them */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Equipment")
+	bool CanUseItemAtEquipmentSlot(const FEquippedSlot& EquippedSlot) const;
+
+	/* Seconds left before the slot can be used again, 0 if it is not cooling down */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Equipment")
+	float GetEquipmentSlotCooldownRemaining(const FEquippedSlot& EquippedSlot) const;
+
+	/* Charges left in the slot, -1 if the item stored within does not use charges */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Equipment")
+	int32 GetEquipmentSlotCharges(const FEquippedSlot& EquippedSlot) const;
+
+	UFUNCTION()
+	FOnEquipmentSlotUseStateChanged& GetEquipmentSlotUseStateChangedDelegate();
+
+	/* Called by the cooldown subsystem when one of our timers expires, Item is the item that was used from the slot */
+	void HandleCooldownTimerExpired(const FEquippedSlot& EquippedSlot, TObjectKey<UItem> Item, EInventoryCooldownTimerType Type);
+
+protected:
+
+	/* Spends a charge and starts any cooldown or charge recovery for an item that was just used from a slot */
+	void StartEquipmentSlotCooldown(const FEquippedSlot& EquippedSlot, const UItem* Item);
+
+	/* Cancels every cooldown and charge recovery timer we started and forgets all spent charges */
+	void ClearEquipmentSlotUseStates();
+
+	UInventoryCooldownSubsystem* GetCooldownSubsystem() const;
+
+private:
+
+	/* Use state of the item currently stored in a slot, null if it has nothing to recover */
+	const FEquipmentSlotUseState* FindEquipmentSlotUseState(const FEquippedSlot& EquippedSlot) const;
+
+	void NotifyEquipmentSlotUseStateChanged(const FEquippedSlot& EquippedSlot);
+
+	int32 BroadcastEquipmentSlotUseStateChanged(const FEquippedSlot& EquippedSlot);
+
+	TInventoryInlineMap<FEquipmentSlotUseStateKey, FEquipmentSlotUseState, InlineEquipmentCapacity> EquipmentSlotUseStates;
+
+
+	/**********************************************************
+	 ***             Equipped Item Instances               ****
+	 *********************************************************/
+
+protected:
+
+	/* Spawns an actor of the item's ItemInstanceClass for every equipped item. Actors come from the world's actor pool
+	 * and go back to it when the item is unequipped, so swapping equipment does not construct or destroy actors */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System Component | Equipment")
+	bool bSpawnEquippedItemInstances;
+
+public:
+
+	/* Actor spawned for the item stored in an equipment slot, null if none was spawned */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Equipment")
+	AActor* GetEquippedItemInstance(const FEquippedSlot& EquippedSlot) const;
+
+protected:
+
+	/* Returns the slot's instance actor to the pool and takes one for the item now stored within */
+	void UpdateEquippedItemInstance(const FEquippedSlot& EquippedSlot, UItem* Item);
+
+	/* Fills the pools with an actor for every default item that can be equipped but is not yet */
+	void PrewarmItemInstancePools();
+
+	void ReleaseEquippedItemInstances();
+
+private:
+
+	TInventoryInlineMap<FEquippedSlot, TWeakObjectPtr<AActor>, InlineEquipmentCapacity> EquippedItemInstances;
+
+
+	/**********************************************************
+	 ***                   Shared Access                   ****
+	 *********************************************************/
+
+	/* Every write to an inventory slot or equipment slot stamps it with the next inventory version. Callers sharing a
+	 * component, such as the members of a party stash, pass the version they last read to the IfVersion functions, a
+	 * request made against a stale version is rejected and hands back the current version instead of being applied.
+	 *
+	 * Viewers registered with AddInventoryViewer turn on the change journal, a ring of the most recent writes. The
+	 * component broadcasts OnInventoryChangesAvailable at most once per frame and each viewer pulls what it missed with
+	 * GetChangesSince, falling back to a full read only when it fell further behind than the journal reaches.
+	 */
+
+protected:
+
+	/* Number of writes the change journal remembers while viewers are registered */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System Component | Shared Access")
+	int32 ChangeJournalCapacity;
+
+	/* Broadcast once per frame while viewers are registered and the inventory changed since the last broadcast */
+	UPROPERTY(BlueprintAssignable)
+	FOnInventoryChangesAvailable OnInventoryChangesAvailable;
+
+public:
+
+	/* Latest version written to this inventory, 0 if nothing has been written yet */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Shared Access")
+	int64 GetInventoryVersion() const;
+
+	/* Version the item's slot was last written at, 0 if the item is not in our inventory */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Shared Access")
+	int64 GetItemVersion(const UItem* Item) const;
+
+	/* Version the equipment slot was last written at, 0 if the slot does not exist */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Shared Access")
+	int64 GetEquipmentSlotVersion(const FEquippedSlot& EquippedSlot) const;
+
+	/* Adds to the item's stack if its slot is still at ExpectedVersion, OutVersion is the slot version once we are done */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool AddItemIfVersion(UItem* Item, int StackCount, int64 ExpectedVersion, int64& OutVersion);
+
+	/* Removes from the item's stack if its slot is still at ExpectedVersion, OutVersion is the slot version once we are done */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool RemoveItemIfVersion(UItem* Item, int StackCount, int64 ExpectedVersion, int64& OutVersion);
+
+	/* Sets the item's state data if its slot is still at ExpectedVersion, OutVersion is the slot version once we are done */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool SetItemStateDataIfVersion(UItem* Item, FItemStateData ItemStateData, int64 ExpectedVersion, int64& OutVersion);
+
+	/* Stores the item in the equipment slot if the slot is still at ExpectedVersion, OutVersion is the slot version once we are done */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool AddItemToEquipmentSlotIfVersion(const FEquippedSlot& EquippedSlot, UItem* Item, int64 ExpectedVersion, int64& OutVersion);
+
+	/* Empties the equipment slot if the slot is still at ExpectedVersion, OutVersion is the slot version once we are done */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool RemoveItemFromEquipmentSlotIfVersion(const FEquippedSlot& EquippedSlot, int64 ExpectedVersion, int64& OutVersion);
+
+	/* Registers an object reading this inventory and returns the version its initial read is current as of */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	int64 AddInventoryViewer(UObject* Viewer);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	void RemoveInventoryViewer(UObject* Viewer);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Shared Access")
+	int32 GetInventoryViewerCount() const;
+
+	/* Collects the latest change of every slot written after SinceVersion, oldest first. Returns false if the journal no
+	 * longer reaches back that far, the caller should read the inventory again and continue from GetInventoryVersion */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Shared Access")
+	bool GetChangesSince(int64 SinceVersion, TArray<FInventoryChangeRecord>& OutChanges);
+
+	UFUNCTION()
+	FOnInventoryChangesAvailable& GetInventoryChangesAvailableDelegate();
+
+protected:
+
+	/* Stamps a write with the next inventory version and records it in the change journal, returns the new version */
+	int64 RecordChange(UItem* Item, int32 StackCount, const FEquippedSlot& EquippedSlot = FEquippedSlot());
+
+	/* Broadcasts OnInventoryChangesAvailable if anything was written since the last broadcast */
+	void BroadcastChangesAvailable();
+
+	/* Ticks while deferred events or viewers need it */
+	void UpdateComponentTickEnabled();
+
+private:
+
+	int64 InventoryVersion;
+
+	// Version OnInventoryChangesAvailable was last broadcast for
+	int64 BroadcastInventoryVersion;
+
+	// First version recorded since the journal was last started, 0 while it is off
+	int64 ChangeJournalStartVersion;
+
+	// Ring of recent writes, the write made at version V is stored at (V - 1) % ChangeJournalCapacity
+	UPROPERTY(Transient)
+	TArray<FInventoryChangeRecord> ChangeJournal;
+
+	/* Most viewers are up to date and ask for the same range, the collapsed result is kept for the next caller */
+	UPROPERTY(Transient)
+	TArray<FInventoryChangeRecord> CachedChanges;
+
+	int64 CachedChangesSinceVersion;
+
+	int64 CachedChangesToVersion;
+
+	TArray<TWeakObjectPtr<UObject>> InventoryViewers;
+
+	TInventoryInlineMap<FEquippedSlot, int64, InlineEquipmentCapacity> EquipmentSlotVersions;
+
+
+	/**********************************************************
+	 ***                  Async Commands                   ****
+	 *********************************************************/
+
+public:
+
+	/* The Enqueue functions may be called from any thread while the caller keeps this component alive. They queue a mutation
+	 * in the world's command queue without allocating and return false if the queue is full, we are not registered or our
+	 * world is being torn down. Queued mutations are applied on the game thread once per frame, through the same function
+	 * a direct call would use */
+
+	bool EnqueueAddItem(UItem* Item, int32 StackCount = 1);
+
+	bool EnqueueRemoveItem(UItem* Item, int32 StackCount = 1);
+
+	bool EnqueueTryEquipItem(UItem* Item, const FEquippedSlot& OptionalSlot = FEquippedSlot());
+
+	bool EnqueueSetItemStateData(UItem* Item, const FItemStateData& ItemStateData);
+
+	virtual void OnRegister() override;
+
+	virtual void OnUnregister() override;
+
+private:
+
+	bool EnqueueCommand(FInventoryCommand&& Command);
+
+	// Our world's command channel while we are registered. Set on the game thread and copied by producers under the lock,
+	// the copy keeps the queue alive even if we are unregistered or the world goes away while they queue
+	TSharedPtr<FInventoryCommandChannel, ESPMode::ThreadSafe> CommandChannel;
+
+	mutable FRWLock CommandChannelLock;
+
+
+	/**********************************************************
+	 ***                  Event Dispatch                   ****
+	 *********************************************************/
+
+protected:
+
+	/* How item and equipment slot changed events are broadcast, Deferred collapses all changes made in a frame into one event per item / slot */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory System Component | Events")
+	EInventoryEventDispatchMode EventDispatchMode;
+
+	/* Tick group deferred events are flushed in */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System Component | Events")
+	TEnumAsByte<ETickingGroup> EventFlushTickGroup;
+
+public:
+
+	/* Switching away from Deferred flushes any pending events first */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Events")
+	void SetEventDispatchMode(EInventoryEventDispatchMode NewDispatchMode);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Events")
+	EInventoryEventDispatchMode GetEventDispatchMode() const;
+
+	/* Number of broadcasts the last deferred flush avoided compared to dispatching immediately */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Inventory System Component | Events")
+	int32 GetBroadcastsSavedLastFlush() const;
+
+	/* Broadcasts the net change of every item and equipment slot modified since the last flush */
+	UFUNCTION(BlueprintCallable, Category = "Inventory System Component | Events")
+	void FlushDeferredEvents();
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+
+	/* Called after an item's stack count changed, broadcasts now or records the change for the next flush */
+	void NotifyItemChanged(UItem* Item, int32 OldStackCount, int32 NewStackCount);
+
+	/* Called after an equipment slot was written, ChangeType says whether the caller stored or removed an item. Immediate
+	 * dispatch broadcasts that one event with the item it names, even if the slot already held it or was already empty.
+	 * Deferred dispatch records the slot's item for the next flush, which broadcasts the net change */
+	void NotifyEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem, EEquipmentSlotChangeType ChangeType);
+
+	/* Broadcasts a stack count change, returns the number of delegates broadcast. Stack count listeners hear about growing
+	 * stacks before OnItemChanged and shrinking stacks after it, and nothing about removed items */
+	int32 BroadcastItemChanged(UItem* Item, int32 OldStackCount, int32 NewStackCount);
+
+	/* Broadcasts the net change of an equipment slot, Removed for the item it lost and Added for the item it gained.
+	 * Returns the number of delegates broadcast */
+	int32 BroadcastEquipmentSlotChanged(const FEquippedSlot& EquippedSlot, UItem* OldItem, UItem* NewItem);
+
+	void NotifyEquipmentLoadoutApplied(FName LoadoutName, const TArray<FEquippedSlot>& ChangedSlots);
+
+	struct FPendingEquipmentLoadout
+	{
+		FName LoadoutName;
+		TArray<FEquippedSlot> ChangedSlots;
+	};
+
+private:
+
+	// Stack count of each item before its first change since the last flush
+	FItemChangeStorage PendingItemChanges;
+
+	// Item stored in each equipment slot before its first change since the last flush
+	FEquipmentChangeStorage PendingEquipmentChanges;
+
+	// Slots whose use state changed since the last flush
+	TArray<FEquippedSlot> PendingEquipmentUseStateChanges;
+
+	// Loadouts applied since the last flush in the order they were first applied
+	TArray<FPendingEquipmentLoadout> PendingEquipmentLoadouts;
+
+	// Broadcasts immediate dispatch would have made since the last flush
+	int32 PendingBroadcastCount;
+
+	int32 BroadcastsSavedLastFlush;
+
+private:
+
+	friend class FInventoryTraceScope;
+	friend class FInventoryTraceBroadcastScope;
+
+	// Trace scopes open on this component, only our outermost call is recorded
+	mutable int32 TraceScopeDepth;
 };
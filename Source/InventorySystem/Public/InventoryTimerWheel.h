@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Handle to a timer in a TInventoryTimerWheel, stays safe to use after the timer expired or was cancelled */
+struct FInventoryTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+
+	void Invalidate()
+	{
+		Index = INDEX_NONE;
+		Serial = 0;
+	}
+};
+
+/**
+ * Hierarchical timer wheel.
+ *
+ * Time is measured in ticks of a fixed resolution. Timers due within the next 256 ticks live in the first level, one slot
+ * per tick; each further level covers 256 times the range of the one below it with the same number of slots. When the
+ * first level wraps around, the next slot of the level above is cascaded down. Adding and cancelling a timer are O(1),
+ * advancing costs one slot visit per elapsed tick plus the timers that expire or cascade, and nothing at all while the
+ * wheel is empty.
+ *
+ * Timers live in a single node array linked into per slot lists by index, freed nodes are reused so a steady state
+ * workload does not allocate.
+ */
+template<typename PayloadType>
+class TInventoryTimerWheel
+{
+public:
+
+	static constexpr int32 NumLevels = 4;
+	static constexpr int32 SlotBits = 8;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr uint64 SlotMask = NumSlots - 1;
+
+	TInventoryTimerWheel()
+		: CurrentTick(0)
+		, FreeList(INDEX_NONE)
+		, ActiveCount(0)
+	{
+		for(int32 Level = 0; Level < NumLevels; Level++)
+		{
+			for(int32 Slot = 0; Slot < NumSlots; Slot++)
+			{
+				Heads[Level][Slot] = INDEX_NONE;
+			}
+		}
+	}
+
+	uint64 GetCurrentTick() const { return CurrentTick; }
+
+	int32 Num() const { return ActiveCount; }
+
+	/* Adds a timer expiring DelayTicks from now, a delay of zero expires on the next tick */
+	FInventoryTimerHandle Add(uint64 DelayTicks, PayloadType&& Payload)
+	{
+		int32 Index = FreeList;
+		if(Index != INDEX_NONE)
+		{
+			FreeList = Nodes[Index].Next;
+		}
+		else
+		{
+			Index = Nodes.AddDefaulted();
+		}
+
+		FNode& Node = Nodes[Index];
+		Node.Payload = MoveTemp(Payload);
+		Node.ExpireTick = CurrentTick + FMath::Max<uint64>(1, DelayTicks);
+		Node.bActive = true;
+		Link(Index);
+		ActiveCount++;
+
+		FInventoryTimerHandle Handle;
+		Handle.Index = Index;
+		Handle.Serial = Node.Serial;
+		return Handle;
+	}
+
+	/* Cancels a timer if it is still pending, the handle is invalidated either way */
+	bool Cancel(FInventoryTimerHandle& Handle)
+	{
+		const bool bWasActive = IsActive(Handle);
+		if(bWasActive)
+		{
+			Unlink(Handle.Index);
+			Free(Handle.Index);
+		}
+
+		Handle.Invalidate();
+		return bWasActive;
+	}
+
+	bool IsActive(const FInventoryTimerHandle& Handle) const
+	{
+		return Nodes.IsValidIndex(Handle.Index) && Nodes[Handle.Index].bActive && Nodes[Handle.Index].Serial == Handle.Serial;
+	}
+
+	/* Ticks left before the timer expires, zero if it is no longer active */
+	uint64 GetRemainingTicks(const FInventoryTimerHandle& Handle) const
+	{
+		return IsActive(Handle) ? Nodes[Handle.Index].ExpireTick - CurrentTick : 0;
+	}
+
+	/* Advances the wheel to NewTick and appends the payload of every timer that expired to OutExpired */
+	template<typename AllocatorType>
+	void Advance(uint64 NewTick, TArray<PayloadType, AllocatorType>& OutExpired)
+	{
+		if(ActiveCount == 0)
+		{
+			CurrentTick = FMath::Max(CurrentTick, NewTick);
+			return;
+		}
+
+		while(CurrentTick < NewTick && ActiveCount > 0)
+		{
+			CurrentTick++;
+
+			/* When a level wraps around, pull the next slot of the level above down into the levels below it */
+			for(int32 Level = 1; Level < NumLevels; Level++)
+			{
+				if((CurrentTick & ((1ull << (SlotBits * Level)) - 1)) != 0)
+				{
+					break;
+				}
+
+				Cascade(Level, (int32)((CurrentTick >> (SlotBits * Level)) & SlotMask));
+			}
+
+			int32& Head = Heads[0][CurrentTick & SlotMask];
+			int32 Index = Head;
+			Head = INDEX_NONE;
+
+			while(Index != INDEX_NONE)
+			{
+				const int32 Next = Nodes[Index].Next;
+				OutExpired.Add(MoveTemp(Nodes[Index].Payload));
+				Free(Index);
+				Index = Next;
+			}
+		}
+
+		CurrentTick = FMath::Max(CurrentTick, NewTick);
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Nodes.GetAllocatedSize();
+	}
+
+private:
+
+	struct FNode
+	{
+		PayloadType Payload;
+		uint64 ExpireTick = 0;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		uint32 Serial = 0;
+		uint8 Level = 0;
+		uint8 Slot = 0;
+		bool bActive = false;
+	};
+
+	void Link(int32 Index)
+	{
+		FNode& Node = Nodes[Index];
+		const uint64 Delta = Node.ExpireTick > CurrentTick ? Node.ExpireTick - CurrentTick : 0;
+
+		int32 Level = 0;
+		while(Level < NumLevels - 1 && Delta >= (1ull << (SlotBits * (Level + 1))))
+		{
+			Level++;
+		}
+
+		// Anything past the range of the top level waits in its furthest slot and is cascaded again when it comes around
+		const uint64 LevelTick = FMath::Min(Node.ExpireTick, CurrentTick + (1ull << (SlotBits * NumLevels)) - 1);
+		Node.Level = (uint8)Level;
+		Node.Slot = (uint8)((LevelTick >> (SlotBits * Level)) & SlotMask);
+
+		int32& Head = Heads[Node.Level][Node.Slot];
+		Node.Prev = INDEX_NONE;
+		Node.Next = Head;
+		if(Head != INDEX_NONE)
+		{
+			Nodes[Head].Prev = Index;
+		}
+		Head = Index;
+	}
+
+	void Unlink(int32 Index)
+	{
+		FNode& Node = Nodes[Index];
+		if(Node.Prev != INDEX_NONE)
+		{
+			Nodes[Node.Prev].Next = Node.Next;
+		}
+		else
+		{
+			Heads[Node.Level][Node.Slot] = Node.Next;
+		}
+
+		if(Node.Next != INDEX_NONE)
+		{
+			Nodes[Node.Next].Prev = Node.Prev;
+		}
+
+		Node.Prev = INDEX_NONE;
+		Node.Next = INDEX_NONE;
+	}
+
+	void Free(int32 Index)
+	{
+		FNode& Node = Nodes[Index];
+		Node.Payload = PayloadType();
+		Node.bActive = false;
+		Node.Serial++;
+		Node.Prev = INDEX_NONE;
+		Node.Next = FreeList;
+		FreeList = Index;
+		ActiveCount--;
+	}
+
+	void Cascade(int32 Level, int32 Slot)
+	{
+		int32 Index = Heads[Level][Slot];
+		Heads[Level][Slot] = INDEX_NONE;
+
+		while(Index != INDEX_NONE)
+		{
+			const int32 Next = Nodes[Index].Next;
+			Link(Index);
+			Index = Next;
+		}
+	}
+
+	TArray<FNode> Nodes;
+
+	int32 Heads[NumLevels][NumSlots];
+
+	uint64 CurrentTick;
+
+	int32 FreeList;
+
+	int32 ActiveCount;
+};
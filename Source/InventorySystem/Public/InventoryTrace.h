@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ItemTypes.h"
+#include <atomic>
+
+class UInventorySystemComponent;
+class UItem;
+
+/* Every inventory component API call that can be captured in a trace */
+enum class EInventoryTraceOp : uint8
+{
+	None,
+	AddItem,
+	AddItemAndEquip,
+	RemoveItem,
+	SetItemStateData,
+	GetItemStateData,
+	GetInventoryItems,
+	GetItemStackCount,
+	HasItem,
+	TryEquipItem,
+	UseItemAtEquipmentSlot,
+	GetTotalEquipmentSlotsOfType,
+	IsItemEquipped,
+	GetItemAtEquipmentSlot,
+	GetFirstAvailableEquipmentSlot,
+	AddItemToEquipmentSlot,
+	RemoveItemFromEquipmentSlot,
+	AddEquipmentSlot,
+	SaveEquipmentLoadout,
+	ApplyEquipmentLoadout,
+	RemoveEquipmentLoadout,
+
+	Count
+};
+
+INVENTORYSYSTEM_API const TCHAR* LexToString(EInventoryTraceOp Op);
+
+/* Kind of a string definition stored in a trace, definitions map the ids used by records back to objects and names */
+enum class EInventoryTraceDefinitionKind : uint8
+{
+	Object,
+	Name
+};
+
+/**
+ * A single captured API call. Objects and names are stored as ids into the definitions written ahead of the records that use them.
+ * Only the arguments used by the operation are serialized.
+ */
+struct INVENTORYSYSTEM_API FInventoryTraceRecord
+{
+	uint64 Frame = 0;
+	uint32 ComponentId = 0;
+	uint32 ItemId = 0;
+	// Slot type, item type filter or loadout name depending on the operation
+	uint32 NameId = 0;
+	int32 SlotNumber = INDEX_NONE;
+	int32 IntArg = 0;
+	EInventoryTraceOp Op = EInventoryTraceOp::None;
+
+	float Magnitude = 0.f;
+	FVector3f Location = FVector3f::ZeroVector;
+	uint32 OptionalObjectId = 0;
+
+	/* Which of the arguments an operation uses, only those are written to the trace */
+	static bool UsesItem(EInventoryTraceOp Op);
+	static bool UsesIntArg(EInventoryTraceOp Op);
+	static bool UsesSlot(EInventoryTraceOp Op);
+	static bool UsesStateData(EInventoryTraceOp Op);
+
+	friend INVENTORYSYSTEM_API FArchive& operator<<(FArchive& Ar, FInventoryTraceRecord& Record);
+};
+
+/* File layout shared by the recorder and the replay commandlet */
+namespace InventoryTraceFormat
+{
+	// 'INVT'
+	static constexpr uint32 Magic = 0x54564E49;
+	static constexpr uint32 Version = 1;
+
+	// A chunk is a chunk type byte followed by a uint32 entry count and the entries
+	static constexpr uint8 DefinitionsChunk = 1;
+	static constexpr uint8 RecordsChunk = 2;
+}
+
+/**
+ * Captures inventory component API calls to a binary trace file.
+ *
+ * Records are pushed on the game thread into a fixed size single producer ring buffer and written to disk by a background
+ * thread, recording never blocks on file IO. If the writer falls behind, records are dropped and counted instead.
+ * Only top level calls are recorded, calls a component makes into itself (AddItem auto equipping for example) are not,
+ * so replaying a trace reproduces them naturally. Calls made by our listeners while we broadcast, and calls into other
+ * components, come from outside and are recorded.
+ */
+class INVENTORYSYSTEM_API FInventoryTrace
+{
+public:
+
+	static bool StartRecording(const FString& Filename);
+
+	static void StopRecording();
+
+	static bool IsRecording() { return bRecording.load(std::memory_order_relaxed); }
+
+	/* Number of records dropped because the ring buffer was full */
+	static uint64 GetDroppedRecordCount();
+
+	static void RecordOperation(const UInventorySystemComponent* Component, EInventoryTraceOp Op, const UObject* Item, int32 IntArg, const FEquippedSlot& Slot, const FItemStateData* StateData);
+
+private:
+
+	static std::atomic<bool> bRecording;
+};
+
+/* Records an API call when it is the outermost call on its component, place at the top of every traced function.
+ * A scope with EInventoryTraceOp::None records nothing but still hides the calls the component makes into itself inside it */
+class INVENTORYSYSTEM_API FInventoryTraceScope
+{
+public:
+
+	FInventoryTraceScope(const UInventorySystemComponent* Component, EInventoryTraceOp Op, const UObject* Item = nullptr, int32 IntArg = 0, const FEquippedSlot& Slot = FEquippedSlot(), const FItemStateData* StateData = nullptr);
+
+	/* For operations whose only argument is a name */
+	FInventoryTraceScope(const UInventorySystemComponent* Component, EInventoryTraceOp Op, FName Name);
+
+	~FInventoryTraceScope();
+
+private:
+
+	const UInventorySystemComponent* Component;
+};
+
+/* Place around a component broadcasting to its listeners, the calls they make back into it are theirs and get recorded */
+class INVENTORYSYSTEM_API FInventoryTraceBroadcastScope
+{
+public:
+
+	explicit FInventoryTraceBroadcastScope(const UInventorySystemComponent* InComponent);
+
+	~FInventoryTraceBroadcastScope();
+
+private:
+
+	const UInventorySystemComponent* Component;
+	int32 SavedScopeDepth;
+};
@@ -8,6 +8,9 @@
 #include "Item.generated.h"
 
 class UInventorySystemComponent;
+class UStaticMesh;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnItemSortKeysChanged, UItem*);
 
 /**
  * 
@@ -38,6 +41,10 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item | Info")
 	UTexture2D* ItemImageSoftPointer;
 
+	// Mesh drawn for this item while it lies in the world as a pickup, drops of items without one are not drawn
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item | Info")
+	UStaticMesh* PickupMesh;
+
 	// If we can be stacked, our max stack count, defaults to -1 if we have unlimited stacks
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Info")
 	int32 MaxStackCount;
@@ -48,6 +55,18 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Info")
 	bool bIsStackable;
 
+	// Seconds before an equipment slot holding this item can be used again, 0 if the item has no cooldown
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Use")
+	float UseCooldown;
+
+	// Uses available while equipped, each use spends a charge. 0 if the item can be used without charges
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Use")
+	int32 MaxCharges;
+
+	// Seconds to recover a single spent charge, 0 if charges never recover
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Use")
+	float ChargeRecoveryTime;
+
 	virtual FPrimaryAssetType GetItemType() const override;
 
 	virtual FName GetItemName() const;
@@ -62,8 +81,29 @@ public:
 
 	virtual bool ConsumeOnUse() const override;
 
+	virtual float GetUseCooldown() const;
+
+	virtual int32 GetMaxCharges() const;
+
+	virtual float GetChargeRecoveryTime() const;
+
 	UFUNCTION(BlueprintCallable, Category = "Item")
 	FString GetIdentifierString() const;
 
+	/* Renames the item and lets sorted views move its row */
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	void SetItemName(FName NewItemName);
+
+	/* Changes the item type and lets sorted views move or filter its row */
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	void SetItemType(FPrimaryAssetType NewItemType);
+
+	/* Broadcast when the name or type of any item changes through the setters above or an edit in the editor */
+	static FOnItemSortKeysChanged& OnItemSortKeysChanged();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
 };
@@ -8,6 +8,7 @@
 
 class UInventorySystemComponent;
 class UItem;
+class UPackageMap;
 
 /**
  * 
@@ -22,11 +23,17 @@ struct FItemStateData
 	{
 		Magnitude = 0.f;
 		OptionalObject = nullptr;
+		LocationData = FVector::ZeroVector;
 	}
 
 	bool operator==(FItemStateData& Other) const { return this->Magnitude == Other.Magnitude && this->OptionalObject == Other.OptionalObject; }
 	bool operator!=(FItemStateData& Other) const { return !(*this == Other); }
 
+	bool IsDefault() const { return Magnitude == 0.f && !OptionalObject && LocationData.IsZero(); }
+
+	/* Only fields that differ from their defaults are sent, Magnitude and LocationData are quantized as set by the Inventory.Net cvars */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	float Magnitude;
 
@@ -37,6 +44,15 @@ struct FItemStateData
 	FVector LocationData;
 };
 
+template<>
+struct TStructOpsTypeTraits<FItemStateData> : public TStructOpsTypeTraitsBase2<FItemStateData>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 USTRUCT(BlueprintType)
 struct FEquippedSlot
 {
@@ -82,6 +98,18 @@ struct FEquippedSlot
 	{
 		return Item && Item->ItemType == this->SlotType && SlotNumber >= 0;
 	}
+
+	/* Slot types listed in Inventory.Net.SlotTypes are sent as an index, anything else falls back to its name */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FEquippedSlot> : public TStructOpsTypeTraitsBase2<FEquippedSlot>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
 };
 
 USTRUCT(BlueprintType)
@@ -108,12 +136,14 @@ struct FInventorySlotData
 	{
 		StackCount = -1;
 		ItemData = FItemStateData();
+		Version = 0;
 	}
 
 	FInventorySlotData(int InStackCount, FItemStateData InItemData = FItemStateData())
 	{
 		StackCount = InStackCount;
 		ItemData = InItemData;
+		Version = 0;
 	}
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -122,6 +152,10 @@ struct FInventorySlotData
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FItemStateData ItemData;
 
+	// Inventory version this slot was last written at, 0 if the item is not in the inventory
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int64 Version;
+
 	bool IsValid() const { return StackCount > 0;  }
 	bool operator==(FInventorySlotData& Other) const { return this->StackCount == Other.StackCount && this->ItemData == Other.ItemData; }
 	bool operator!=(FInventorySlotData& Other) const { return !(*this == Other); }
@@ -135,6 +169,60 @@ struct FInventorySlotData
 
 		StackCount = FMath::Clamp(StackCount + Other.StackCount, 0, MaxCount);
 	}
+
+	/* Stack counts and versions are sent as variable length integers, item data only when it differs from its defaults */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventorySlotData> : public TStructOpsTypeTraitsBase2<FInventorySlotData>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/* Snapshot of what is stored in each equipment slot, applied back to a component in a single operation */
+USTRUCT(BlueprintType)
+struct FEquipmentLoadout
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TMap<FEquippedSlot, UItem*> Slots;
+};
+
+/* A single write to an inventory slot or equipment slot, as recorded in a component's change journal */
+USTRUCT(BlueprintType)
+struct FInventoryChangeRecord
+{
+	GENERATED_BODY()
+
+	FInventoryChangeRecord()
+	{
+		Version = 0;
+		Item = nullptr;
+		StackCount = 0;
+	}
+
+	// Inventory version the change was made at
+	UPROPERTY(BlueprintReadOnly)
+	int64 Version;
+
+	// Item whose stack count changed, or the item now stored in the equipment slot
+	UPROPERTY(BlueprintReadOnly)
+	UItem* Item;
+
+	// Stack count after the change, 0 once the item was removed. Unused for equipment slot changes
+	UPROPERTY(BlueprintReadOnly)
+	int32 StackCount;
+
+	// Equipment slot that changed, invalid for inventory slot changes
+	UPROPERTY(BlueprintReadOnly)
+	FEquippedSlot EquippedSlot;
+
+	bool IsEquipmentSlotChange() const { return EquippedSlot.IsValid(); }
 };
 
 UENUM(BlueprintType)